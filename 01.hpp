@@ -11,6 +11,7 @@
 #include <iostream>
 
 #include <bits/stdc++.h> 
+#include "DigraphCsr.hpp"
 using namespace std;
 
 class DigraphException : public std::runtime_error
@@ -110,13 +111,18 @@ public:
         int startVertex,
         std::function<double(const EdgeInfo&)> edgeWeightFunc) const;
 
+    std::map<int, int> findShortestPaths(
+        int startVertex,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc,
+        std::map<int, double>& distances) const;
+
 
 private:
   
     std::map<int, DigraphVertex<VertexInfo, EdgeInfo>> vmap;
 
     void checkVertexExistence(int vertex) const;
-    void dft(std::vector<int>& vertex_list, const std::pair<int, DigraphVertex<VertexInfo, EdgeInfo>>& vertex) const;
+    void buildCsr(DigraphCsr& csr, std::vector<const EdgeInfo*>& einfos) const;
 
 
 };
@@ -322,81 +328,45 @@ int Digraph<VertexInfo, EdgeInfo>::edgeCount(int vertex) const
 template <typename VertexInfo, typename EdgeInfo>
 bool Digraph<VertexInfo, EdgeInfo>::isStronglyConnected() const
 {
-    for (const auto &v : vmap)
-    {
-        std::vector<int> vertex_list;
-
-        dft(vertex_list, v);
-        if (vertex_list.size() != vertices().size())
-        {
-            return false;
-        }
-    }
-    return true;
+    DigraphCsr csr;
+    std::vector<const EdgeInfo*> einfos;
+    buildCsr(csr, einfos);
+    return csrIsStronglyConnected(csr);
 }
 
 template <typename VertexInfo, typename EdgeInfo>
-void Digraph<VertexInfo, EdgeInfo>::dft(std::vector<int>& vertex_list, const std::pair<int, DigraphVertex<VertexInfo, EdgeInfo>>& vertex) const
+std::map<int, int> Digraph<VertexInfo, EdgeInfo>::findShortestPaths(
+    int startVertex,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc) const
 {
-    vertex_list.push_back(vertex.first);
-
-    for (const auto &e : vertex.second.edges)
-    {
-        if (std::find(vertex_list.begin(), vertex_list.end(), e.toVertex) == vertex_list.end())
-        {
-            dft(vertex_list, *vmap.find(e.toVertex));
-        }
-    }
+    std::map<int, double> distances;
+    return findShortestPaths(startVertex, edgeWeightFunc, distances);
 }
 
+
 template <typename VertexInfo, typename EdgeInfo>
 std::map<int, int> Digraph<VertexInfo, EdgeInfo>::findShortestPaths(
     int startVertex,
-    std::function<double(const EdgeInfo&)> edgeWeightFunc) const
+    std::function<double(const EdgeInfo&)> edgeWeightFunc,
+    std::map<int, double>& distances) const
 {
+    checkVertexExistence(startVertex);
 
-    std::vector<int> vertex_list;
-    std::map<int, int> vertex_d;
-    std::map<int, int> vertex_p;
+    DigraphCsr csr;
+    std::vector<const EdgeInfo*> einfos;
+    buildCsr(csr, einfos);
 
-    for (auto &v : vmap)
-    {
-        if (v.first == startVertex)
-        {
-            vertex_d[v.first] = 0;
-            vertex_p[v.first] = v.first;
-        }
-        else
-        {
-            vertex_d[v.first] = INT_MAX;
-        }
-    }
-
-    std::priority_queue<int> pq;
-    pq.push(startVertex);
+    std::vector<double> distance;
+    std::vector<int> predecessor;
+    IndexedHeap<double> heap;
 
-    while (!pq.empty())
-    {
-        int min_priority_vertex = pq.top();
-        pq.pop();
+    csrShortestPaths(
+        csr, csr.indexOf(startVertex),
+        [&](int e) { return edgeWeightFunc(*einfos[e]); },
+        distance, predecessor, heap);
 
-        if (std::find(vertex_list.begin(), vertex_list.end(), min_priority_vertex) == vertex_list.end())
-        {
-            vertex_list.push_back(min_priority_vertex);
-
-            for (auto &v : vmap.find(min_priority_vertex)->second.edges)
-            {
-                if (vertex_d[v.toVertex] > vertex_d[v.fromVertex] + edgeWeightFunc(v.einfo))
-                {
-                    vertex_d[v.toVertex] = vertex_d[v.fromVertex] + edgeWeightFunc(v.einfo);
-                    vertex_p[v.toVertex] = min_priority_vertex;
-                    pq.push(v.toVertex);
-                }
-            }
-        }
-    }
-
-    return vertex_p;
+    distances = csrToMap(csr, distance);
+    return csrIndexMap(csr, predecessor);
 }
 
 
@@ -409,5 +379,38 @@ void Digraph<VertexInfo, EdgeInfo>::checkVertexExistence(int vertex) const
     }
 }
 
-    
+
+template <typename VertexInfo, typename EdgeInfo>
+void Digraph<VertexInfo, EdgeInfo>::buildCsr(DigraphCsr& csr, std::vector<const EdgeInfo*>& einfos) const
+{
+    csr.numbers.clear();
+    csr.offsets.clear();
+    csr.targets.clear();
+    einfos.clear();
+
+    csr.numbers.reserve(vmap.size());
+    csr.offsets.reserve(vmap.size() + 1);
+
+    for (auto const& v : vmap)
+    {
+        csr.numbers.push_back(v.first);
+    }
+
+    DigraphNumberIndex index;
+    index.assign(csr.numbers);
+    csr.offsets.push_back(0);
+
+    for (auto const& v : vmap)
+    {
+        for (auto const& e : v.second.edges)
+        {
+            csr.targets.push_back(index.indexOf(e.toVertex));
+            einfos.push_back(&e.einfo);
+        }
+
+        csr.offsets.push_back(static_cast<int>(csr.targets.size()));
+    }
+}
+
+
 #endif
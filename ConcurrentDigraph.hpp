@@ -0,0 +1,226 @@
+// ConcurrentDigraph.hpp
+//
+// This header file declares a class template called ConcurrentDigraph,
+// a Digraph that many threads can query while others change it.
+//
+// Readers never wait for writers to finish.  A reader asks for a
+// snapshot, which is an immutable FrozenDigraph of the graph as of the
+// last time it was published, and runs its queries on that for as long
+// as it likes; writers carry on changing the graph in the meantime
+// without affecting it.  Snapshots are shared, reference-counted
+// versions of the graph: publishing swaps a new version in atomically,
+// and an old version is freed once the last reader holding it lets go,
+// much like read-copy-update.  The swap goes through atomic_load() and
+// atomic_store() on a std::shared_ptr, which libstdc++ implements with
+// a short spinlock from a global pool, so getting a snapshot is
+// lock-free except for the moment it takes to copy the pointer.
+//
+// Writers take turns.  Their changes go into a private, mutable
+// Digraph and only become visible to readers when they're published.
+// Since publishing freezes the whole graph, it pays to batch changes
+// up and publish them together, either with update() or by calling the
+// mutating member functions and then publish().
+
+#ifndef CONCURRENTDIGRAPH_HPP
+#define CONCURRENTDIGRAPH_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "Digraph.hpp"
+#include "FrozenDigraph.hpp"
+
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator = std::allocator<char>>
+class ConcurrentDigraph
+{
+public:
+    typedef std::shared_ptr<const FrozenDigraph<VertexInfo, EdgeInfo>> Snapshot;
+
+    // The default constructor initializes an empty ConcurrentDigraph,
+    // and the other initializes one holding the given Digraph.  Either
+    // way, the initial graph is published right away.
+    ConcurrentDigraph();
+    explicit ConcurrentDigraph(Digraph<VertexInfo, EdgeInfo, Allocator> d);
+
+    ConcurrentDigraph(const ConcurrentDigraph&) = delete;
+    ConcurrentDigraph& operator=(const ConcurrentDigraph&) = delete;
+
+    // snapshot() returns the most recently published version of the
+    // graph.  It never waits for a writer's changes or a publish() to
+    // finish, only (at most) for another thread's copy of the pointer
+    // to the current version, and the snapshot stays valid (and never
+    // changes) for as long as it's held, whatever writers do.
+    Snapshot snapshot() const;
+
+    // version() returns the number of times the graph has been
+    // published since it was constructed.
+    unsigned long version() const noexcept;
+
+    // The member functions below change the graph, behaving just like
+    // the Digraph member functions of the same names.  Their changes
+    // aren't seen by snapshot() until the next publish().
+    void addVertex(int vertex, const VertexInfo& vinfo);
+    void addEdge(int fromVertex, int toVertex, const EdgeInfo& einfo);
+    void removeVertex(int vertex);
+    void removeEdge(int fromVertex, int toVertex);
+    void setEdgeInfo(int fromVertex, int toVertex, const EdgeInfo& einfo);
+    void addVertices(const std::vector<std::pair<int, VertexInfo>>& batch);
+    void addEdges(const std::vector<DigraphEdge<EdgeInfo>>& batch);
+    void removeEdges(const std::vector<std::pair<int, int>>& batch);
+
+    // publish() makes every change so far visible to snapshot().
+    void publish();
+
+    // update() calls change with the writers' Digraph, so that it can
+    // make any number of changes, and then publishes them all as one
+    // new version.  No other writer runs in the meantime.  If change
+    // throws, nothing is published, but whatever changes it made
+    // before throwing stay in the graph and go out with the next
+    // publish().
+    template <typename Change>
+    void update(Change&& change);
+
+
+private:
+    mutable std::mutex writeLock;
+    Digraph<VertexInfo, EdgeInfo, Allocator> master;
+    Snapshot current;
+    std::atomic<unsigned long> published;
+
+    // publishLocked() publishes master; writeLock must be held.
+    void publishLocked();
+};
+
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::ConcurrentDigraph()
+    : ConcurrentDigraph(Digraph<VertexInfo, EdgeInfo, Allocator>())
+{
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::ConcurrentDigraph(Digraph<VertexInfo, EdgeInfo, Allocator> d)
+    : master{std::move(d)}, published{0}
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    publishLocked();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+typename ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::Snapshot
+ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::snapshot() const
+{
+    return std::atomic_load(&current);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+unsigned long ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::version() const noexcept
+{
+    return published.load();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::addVertex(int vertex, const VertexInfo& vinfo)
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    master.addVertex(vertex, vinfo);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::addEdge(int fromVertex, int toVertex, const EdgeInfo& einfo)
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    master.addEdge(fromVertex, toVertex, einfo);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::removeVertex(int vertex)
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    master.removeVertex(vertex);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::removeEdge(int fromVertex, int toVertex)
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    master.removeEdge(fromVertex, toVertex);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::setEdgeInfo(int fromVertex, int toVertex, const EdgeInfo& einfo)
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    master.setEdgeInfo(fromVertex, toVertex, einfo);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::addVertices(const std::vector<std::pair<int, VertexInfo>>& batch)
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    master.addVertices(batch);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::addEdges(const std::vector<DigraphEdge<EdgeInfo>>& batch)
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    master.addEdges(batch);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::removeEdges(const std::vector<std::pair<int, int>>& batch)
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    master.removeEdges(batch);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::publish()
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    publishLocked();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+template <typename Change>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::update(Change&& change)
+{
+    std::lock_guard<std::mutex> guard{writeLock};
+    change(master);
+    publishLocked();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void ConcurrentDigraph<VertexInfo, EdgeInfo, Allocator>::publishLocked()
+{
+    // The new version is built before it's swapped in, so readers keep
+    // getting the old one until the new one is complete; the old one
+    // is freed by whichever thread drops the last reference to it.
+    Snapshot next = std::make_shared<FrozenDigraph<VertexInfo, EdgeInfo>>(master);
+    std::atomic_store(&current, std::move(next));
+    ++published;
+}
+
+
+
+#endif // CONCURRENTDIGRAPH_HPP
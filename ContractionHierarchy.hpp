@@ -0,0 +1,1139 @@
+// ContractionHierarchy.hpp
+//
+// This header file declares a class called ContractionHierarchy, which
+// preprocesses a graph whose edge weights don't change so that shortest
+// path queries between two vertices can be answered while looking at
+// only a tiny part of it.
+//
+// Preprocessing "contracts" the vertices one at a time, from least to
+// most important.  Contracting a vertex takes it out of the graph and
+// adds a shortcut edge between each pair of its remaining neighbors
+// whose shortest path ran through it, so distances between the vertices
+// that remain are unchanged.  Each vertex's rank is the point at which
+// it was contracted.  A query then runs Dijkstra's algorithm forward
+// from the start vertex and backward from the end vertex, but only ever
+// along edges (original or shortcut) that lead to higher-ranked
+// vertices; the shortest path is found where the two searches meet.
+//
+// Whether a pair of neighbors needs a shortcut is decided by a "witness
+// search", a small Dijkstra search looking for another path that is no
+// longer.  Vertices are ordered by how much contracting them would
+// grow the graph, and each round contracts every vertex that would
+// grow it less than any of its neighbors would.  No two of them are
+// neighbors, so their witness searches run in parallel.  How much a
+// vertex would grow the graph is only estimated, with witness searches
+// that follow at most two arcs, and the estimate is only redone once
+// shortcuts have been added to the vertex's arcs and it's chosen; if
+// it has got worse, the vertex waits for a later round.
+//
+// A query doesn't follow the arcs of a vertex it can tell it reached
+// by a longer path than one through a higher-ranked vertex it has also
+// reached ("stall on demand"), which about halves the vertices it
+// settles.
+//
+// Preprocessing is meant for road-like graphs, where most vertices are
+// unimportant and contracting them adds few shortcuts.  It costs more
+// on graphs without such a hierarchy: the vertices contracted last
+// form a dense core, where each witness search has dozens of arcs to
+// follow from every vertex it settles.  A square grid with random
+// weights (about as hierarchy-free as a sparse graph gets) took, on
+// one thread, 1.7 seconds for 10,000 vertices, 15 seconds for 40,000
+// and a minute for 100,000, ending up with about four times as many
+// arcs as it started with; queries on those grids settled 340, 710 and
+// 1,100 vertices, taking 110, 280 and 690 microseconds.  The time grows
+// faster than the number of vertices, so graphs of a few hundred
+// thousand vertices or more should either have a real hierarchy or be
+// given more threads.
+//
+// A ContractionHierarchy knows nothing of the graph's VertexInfo and
+// EdgeInfo, only of its vertex numbers and the weights it was built
+// with, and can be saved to a file and loaded back, so that it only
+// needs to be built once for a given graph.
+
+#ifndef CONTRACTIONHIERARCHY_HPP
+#define CONTRACTIONHIERARCHY_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Digraph.hpp"
+#include "DigraphCsr.hpp"
+#include "DigraphFile.hpp"
+#include "DigraphRoute.hpp"
+#include "FrozenDigraph.hpp"
+#include "IndexedHeap.hpp"
+
+
+
+class ContractionHierarchy
+{
+public:
+    // A Query holds the scratch space that answering a query needs,
+    // which is as big as the graph.  Passing the same Query to every
+    // query a thread makes means it's only allocated once, and each
+    // query only pays for the vertices it looks at.  A Query may only
+    // be used by one thread at a time.
+    class Query
+    {
+    private:
+        friend class ContractionHierarchy;
+
+        std::vector<double> distance[2];
+        std::vector<int> parent[2];
+        std::vector<int> touched[2];
+        IndexedHeap<double> heap[2];
+    };
+
+    // The default constructor initializes an empty ContractionHierarchy,
+    // with no vertices.
+    ContractionHierarchy();
+
+    // These constructors build the contraction hierarchy for the given
+    // graph, using the given number of threads (or, if it's zero, one
+    // per hardware thread).  edgeWeightFunc(einfo) must return the
+    // non-negative weight of an edge with the given EdgeInfo, and
+    // weights[e] the weight of the edge with index e in csr.targets; if
+    // weights doesn't have one entry per edge, a DigraphException is
+    // thrown.
+    template <typename VertexInfo, typename EdgeInfo, typename Allocator, typename WeightFn>
+    ContractionHierarchy(
+        const Digraph<VertexInfo, EdgeInfo, Allocator>& d,
+        WeightFn&& edgeWeightFunc, unsigned threads = 0);
+
+    template <typename VertexInfo, typename EdgeInfo, typename WeightFn>
+    ContractionHierarchy(
+        const FrozenDigraph<VertexInfo, EdgeInfo>& f,
+        WeightFn&& edgeWeightFunc, unsigned threads = 0);
+
+    ContractionHierarchy(
+        const DigraphCsrView& csr, const std::vector<double>& weights,
+        unsigned threads = 0);
+
+    // save() writes the hierarchy to the file with the given path, and
+    // load() reads one back.  Both throw a DigraphException if the file
+    // can't be written or read.
+    void save(const std::string& path) const;
+    static ContractionHierarchy load(const std::string& path);
+
+    // vertexCount() returns the number of vertices in the graph, and
+    // edgeCount() the number of edges in the hierarchy, counting
+    // shortcuts.
+    int vertexCount() const noexcept;
+    int edgeCount() const noexcept;
+
+    // distance() returns the length of the shortest path between two
+    // vertices, or infinity if there is none, and route() returns the
+    // path itself, with the shortcuts along it expanded back into the
+    // edges they stand for.  If either vertex does not exist, a
+    // DigraphException is thrown instead.
+    double distance(int fromVertex, int toVertex, Query& query) const;
+    double distance(int fromVertex, int toVertex) const;
+    DigraphRoute route(int fromVertex, int toVertex, Query& query) const;
+    DigraphRoute route(int fromVertex, int toVertex) const;
+
+
+private:
+    // Arcs holds one direction of the hierarchy in CSR form.  In up,
+    // the arcs of each vertex lead to the higher-ranked vertices it has
+    // edges to; in down, they lead to the higher-ranked vertices that
+    // have edges to it.  middle is the vertex a shortcut was added for,
+    // or -1 for an original edge.  Everything is a dense index.
+    struct Arcs
+    {
+        std::vector<int> offsets;
+        std::vector<int> ends;
+        std::vector<double> weights;
+        std::vector<int> middles;
+    };
+
+    std::vector<int> numbers;
+    Arcs up;
+    Arcs down;
+
+    // build() contracts the graph.
+    void build(const DigraphCsrView& csr, const std::vector<double>& weights, unsigned threads);
+
+    // indexOf() returns the dense index of the given vertex number,
+    // throwing a DigraphException if there's no such vertex.
+    int indexOf(int vertex) const;
+
+    // search() runs a query between two dense indices and returns the
+    // index where the two searches met, or -1 if they didn't.
+    int search(int from, int to, Query& query, double& cost, int& settled) const;
+
+    // unpack() appends to path the vertex numbers along the edge from
+    // one dense index to another, not including the first; middle is
+    // the edge's middle vertex.
+    void unpack(int from, int to, int middle, std::vector<int>& path) const;
+};
+
+
+
+// The file a ContractionHierarchy is saved in is a header followed by
+// its arrays, each stored as raw bytes in the order they're declared.
+
+struct ContractionHierarchyFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t vertexCount;
+    std::uint64_t upCount;
+    std::uint64_t downCount;
+};
+
+
+const char contractionHierarchyFileMagic[8] = {'C', 'O', 'N', 'T', 'R', 'A', 'C', 'T'};
+const std::uint32_t contractionHierarchyFileVersion = 1;
+
+// A witness search gives up, and the shortcut it was checking for is
+// added, once it has settled this many vertices.  Extra shortcuts cost
+// a little query time but never give wrong answers.  The searches that
+// only estimate a vertex's priority give up much sooner, and only look
+// for witnesses at most this many arcs long, since a slightly worse
+// order costs much less than the searches would.
+const int contractionWitnessLimit = 500;
+const int contractionEstimateLimit = 50;
+const int contractionEstimateHops = 2;
+
+// Rounds with fewer vertices to work on than this are done on a single
+// thread.
+const int contractionParallelThreshold = 64;
+
+
+
+inline ContractionHierarchy::ContractionHierarchy()
+{
+    up.offsets.push_back(0);
+    down.offsets.push_back(0);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator, typename WeightFn>
+ContractionHierarchy::ContractionHierarchy(
+    const Digraph<VertexInfo, EdgeInfo, Allocator>& d,
+    WeightFn&& edgeWeightFunc, unsigned threads)
+    : ContractionHierarchy(FrozenDigraph<VertexInfo, EdgeInfo>{d}, edgeWeightFunc, threads)
+{
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename WeightFn>
+ContractionHierarchy::ContractionHierarchy(
+    const FrozenDigraph<VertexInfo, EdgeInfo>& f,
+    WeightFn&& edgeWeightFunc, unsigned threads)
+{
+    build(f.csr(), f.edgeWeights(edgeWeightFunc).weight, threads);
+}
+
+
+inline ContractionHierarchy::ContractionHierarchy(
+    const DigraphCsrView& csr, const std::vector<double>& weights, unsigned threads)
+{
+    if (weights.size() != static_cast<std::size_t>(csr.edgeCount()))
+    {
+        throw DigraphException(
+            "Edge weights have " + std::to_string(weights.size())
+            + " entries for " + std::to_string(csr.edgeCount()) + " edges");
+    }
+
+    build(csr, weights, threads);
+}
+
+
+inline void ContractionHierarchy::build(
+    const DigraphCsrView& csr, const std::vector<double>& weights, unsigned threads)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    int n = csr.vertexCount();
+    numbers.assign(csr.numbers, csr.numbers + n);
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // While contraction is going on, the remaining graph is kept as a
+    // list of arcs in each direction for every vertex, with at most one
+    // arc between any two vertices.  An Arc's end is the vertex at its
+    // other end.
+    struct Arc
+    {
+        int end;
+        double weight;
+        int middle;
+    };
+
+    std::vector<std::vector<Arc>> outArcs(n);
+    std::vector<std::vector<Arc>> inArcs(n);
+
+    for (int u = 0; u < n; ++u)
+    {
+        for (int e = csr.offsets[u]; e < csr.offsets[u + 1]; ++e)
+        {
+            int v = csr.targets[e];
+
+            if (u != v)
+            {
+                outArcs[u].push_back(Arc{v, weights[e], -1});
+                inArcs[v].push_back(Arc{u, weights[e], -1});
+            }
+        }
+    }
+
+    struct Shortcut
+    {
+        int from;
+        int to;
+        double weight;
+    };
+
+    // Each thread runs its witness searches with its own Worker.
+    struct Worker
+    {
+        std::vector<double> distance;
+        std::vector<int> hops;
+        std::vector<char> target;
+        std::vector<int> touched;
+        IndexedHeap<double> heap;
+        std::exception_ptr failure;
+    };
+
+    std::vector<Worker> workers(threads);
+
+    for (Worker& worker : workers)
+    {
+        worker.distance.assign(n, infinity);
+        worker.hops.assign(n, 0);
+        worker.target.assign(n, 0);
+    }
+
+    // excluded marks the vertices being contracted in the current round,
+    // which witness searches mustn't pass through, since they're about
+    // to be removed.
+    std::vector<char> excluded(n, 0);
+
+    // contract() finds the shortcuts that contracting v would need,
+    // adding them to shortcuts if it's given, and returns how many
+    // there are.  Without shortcuts, it's only estimating.
+    auto contract = [&](Worker& worker, int v, std::vector<Shortcut>* shortcuts)
+    {
+        int count = 0;
+        int settleLimit = shortcuts != nullptr ? contractionWitnessLimit : contractionEstimateLimit;
+        int hopLimit = shortcuts != nullptr ? n : contractionEstimateHops;
+
+        for (const Arc& in : inArcs[v])
+        {
+            int u = in.end;
+            double limit = -1.0;
+            int targets = 0;
+
+            for (const Arc& out : outArcs[v])
+            {
+                if (out.end != u)
+                {
+                    limit = std::max(limit, in.weight + out.weight);
+                    worker.target[out.end] = 1;
+                    ++targets;
+                }
+            }
+
+            if (targets == 0)
+            {
+                continue;
+            }
+
+            worker.heap.reset(n);
+            worker.distance[u] = 0.0;
+            worker.hops[u] = 0;
+            worker.touched.push_back(u);
+            worker.heap.push(u, 0.0);
+
+            for (int settled = 0; !worker.heap.empty() && settled < settleLimit; ++settled)
+            {
+                double d = worker.heap.topPriority();
+
+                if (d > limit)
+                {
+                    break;
+                }
+
+                int x = worker.heap.pop();
+
+                // Once every target is settled, the search can't find
+                // anything more.
+                if (worker.target[x] && --targets == 0)
+                {
+                    break;
+                }
+
+                if (worker.hops[x] == hopLimit)
+                {
+                    continue;
+                }
+
+                for (const Arc& next : outArcs[x])
+                {
+                    int y = next.end;
+
+                    // A vertex reached by the last hop allowed is never
+                    // expanded, so it's only worth reaching if it's a
+                    // target.
+                    if (y == v || excluded[y] || d + next.weight > limit
+                        || d + next.weight >= worker.distance[y]
+                        || (worker.hops[x] + 1 == hopLimit && !worker.target[y]))
+                    {
+                        continue;
+                    }
+
+                    if (worker.distance[y] == infinity)
+                    {
+                        worker.touched.push_back(y);
+                    }
+
+                    worker.distance[y] = d + next.weight;
+                    worker.hops[y] = worker.hops[x] + 1;
+                    worker.heap.pushOrDecrease(y, d + next.weight);
+                }
+            }
+
+            for (const Arc& out : outArcs[v])
+            {
+                worker.target[out.end] = 0;
+
+                if (out.end != u && worker.distance[out.end] > in.weight + out.weight)
+                {
+                    ++count;
+
+                    if (shortcuts != nullptr)
+                    {
+                        shortcuts->push_back(Shortcut{u, out.end, in.weight + out.weight});
+                    }
+                }
+            }
+
+            for (int x : worker.touched)
+            {
+                worker.distance[x] = infinity;
+            }
+
+            worker.touched.clear();
+        }
+
+        return count;
+    };
+
+    // forEach() calls body(worker, i) for every i in [0, count), sharing
+    // them out among the threads.  If a thread fails, or can't be
+    // started, the exception is rethrown once all of the threads have
+    // stopped.
+    auto forEach = [&](int count, const std::function<void(Worker&, int)>& body)
+    {
+        unsigned team = count < contractionParallelThreshold ? 1 : threads;
+        std::atomic<int> next{0};
+
+        auto work = [&](unsigned t)
+        {
+            Worker& worker = workers[t];
+
+            try
+            {
+                for (int i = next++; i < count; i = next++)
+                {
+                    body(worker, i);
+                }
+            }
+            catch (...)
+            {
+                worker.failure = std::current_exception();
+                next = count;
+            }
+        };
+
+        std::vector<std::thread> helpers;
+
+        try
+        {
+            for (unsigned t = 1; t < team; ++t)
+            {
+                helpers.emplace_back(work, t);
+            }
+        }
+        catch (...)
+        {
+            next = count;
+
+            for (std::thread& helper : helpers)
+            {
+                helper.join();
+            }
+
+            throw;
+        }
+
+        work(0);
+
+        for (std::thread& helper : helpers)
+        {
+            helper.join();
+        }
+
+        for (Worker& worker : workers)
+        {
+            if (worker.failure)
+            {
+                std::exception_ptr failure = worker.failure;
+                worker.failure = nullptr;
+                std::rethrow_exception(failure);
+            }
+        }
+    };
+
+    // A vertex's priority is twice the number of arcs contracting it
+    // would add less the number it would remove, plus the number of its
+    // neighbors already contracted, which spreads contraction evenly
+    // across the graph.  The number of arcs it would add is estimated
+    // once up front, and only estimated again when it may have grown.
+    std::vector<int> estimate(n);
+    std::vector<int> priority(n);
+    std::vector<int> contractedNeighbors(n, 0);
+
+    // countedFor[w] is the last vertex whose contraction was counted in
+    // contractedNeighbors[w], so that a neighbor joined by arcs in both
+    // directions is only counted once.
+    std::vector<int> countedFor(n, -1);
+
+    auto prioritize = [&](int v)
+    {
+        priority[v] = 2 * estimate[v]
+            - static_cast<int>(inArcs[v].size() + outArcs[v].size())
+            + contractedNeighbors[v];
+    };
+
+    auto reestimate = [&](Worker& worker, int v)
+    {
+        estimate[v] = contract(worker, v, nullptr);
+        prioritize(v);
+    };
+
+    // lower() adds an arc, or lowers the weight of the one already there,
+    // and returns whether anything changed.
+    auto lower = [](std::vector<Arc>& arcs, int end, double weight, int middle)
+    {
+        for (Arc& arc : arcs)
+        {
+            if (arc.end == end)
+            {
+                if (weight < arc.weight)
+                {
+                    arc.weight = weight;
+                    arc.middle = middle;
+                    return true;
+                }
+
+                return false;
+            }
+        }
+
+        arcs.push_back(Arc{end, weight, middle});
+        return true;
+    };
+
+    auto remove = [](std::vector<Arc>& arcs, int end)
+    {
+        for (std::size_t i = 0; i < arcs.size(); ++i)
+        {
+            if (arcs[i].end == end)
+            {
+                arcs[i] = arcs.back();
+                arcs.pop_back();
+                return;
+            }
+        }
+    };
+
+    std::vector<int> remaining(n);
+
+    for (int v = 0; v < n; ++v)
+    {
+        remaining[v] = v;
+    }
+
+    forEach(n, [&](Worker& worker, int i) { reestimate(worker, remaining[i]); });
+
+    // When a vertex is contracted, the arcs it has left become its arcs
+    // in the hierarchy, since all of their ends outrank it.
+    std::vector<std::vector<Arc>> upArcs(n);
+    std::vector<std::vector<Arc>> downArcs(n);
+
+    std::vector<char> chosen(n, 0);
+    std::vector<char> changed(n, 0);
+    std::vector<int> round;
+    std::vector<int> neighbors;
+    std::vector<std::vector<Shortcut>> shortcuts;
+
+    // A vertex is stale when a shortcut has been added to its arcs, or
+    // one of them lowered, since its estimate was made.  Contraction
+    // leaves distances between the remaining vertices alone, so losing
+    // an arc to a contracted vertex can only make a vertex's estimate
+    // smaller; gaining one can make it bigger.
+    std::vector<char> stale(n, 0);
+
+    // A vertex is contracted in a round if it comes before each of its
+    // neighbors in order of priority (and then of index).
+    auto before = [&](int a, int b)
+    {
+        return priority[a] < priority[b] || (priority[a] == priority[b] && a < b);
+    };
+
+    auto first = [&](int v)
+    {
+        for (const Arc& arc : inArcs[v])
+        {
+            if (!before(v, arc.end))
+            {
+                return false;
+            }
+        }
+
+        for (const Arc& arc : outArcs[v])
+        {
+            if (!before(v, arc.end))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    while (!remaining.empty())
+    {
+        forEach(static_cast<int>(remaining.size()), [&](Worker&, int i)
+        {
+            int v = remaining[i];
+            chosen[v] = first(v);
+        });
+
+        round.clear();
+
+        for (int v : remaining)
+        {
+            if (chosen[v])
+            {
+                round.push_back(v);
+            }
+        }
+
+        // A stale vertex is only estimated again once it's been chosen,
+        // and put back for a later round if its priority is no longer
+        // ahead of all of its neighbors'.  No two chosen vertices are
+        // neighbors, so this changes no priority another one looks at.
+        forEach(static_cast<int>(round.size()), [&](Worker& worker, int i)
+        {
+            int v = round[i];
+
+            if (stale[v])
+            {
+                stale[v] = 0;
+                reestimate(worker, v);
+                chosen[v] = first(v);
+            }
+        });
+
+        round.erase(
+            std::remove_if(round.begin(), round.end(), [&](int v) { return chosen[v] == 0; }),
+            round.end());
+
+        for (int v : round)
+        {
+            excluded[v] = 1;
+        }
+
+        shortcuts.assign(round.size(), std::vector<Shortcut>{});
+
+        forEach(static_cast<int>(round.size()), [&](Worker& worker, int i)
+        {
+            contract(worker, round[i], &shortcuts[i]);
+        });
+
+        neighbors.clear();
+
+        auto touch = [&](int v, int contracted)
+        {
+            if (countedFor[v] != contracted)
+            {
+                countedFor[v] = contracted;
+                ++contractedNeighbors[v];
+            }
+
+            if (!changed[v])
+            {
+                changed[v] = 1;
+                neighbors.push_back(v);
+            }
+        };
+
+        for (std::size_t i = 0; i < round.size(); ++i)
+        {
+            int v = round[i];
+
+            for (const Arc& arc : inArcs[v])
+            {
+                remove(outArcs[arc.end], v);
+                touch(arc.end, v);
+            }
+
+            for (const Arc& arc : outArcs[v])
+            {
+                remove(inArcs[arc.end], v);
+                touch(arc.end, v);
+            }
+
+            for (const Shortcut& shortcut : shortcuts[i])
+            {
+                if (lower(outArcs[shortcut.from], shortcut.to, shortcut.weight, v))
+                {
+                    stale[shortcut.from] = 1;
+                }
+
+                if (lower(inArcs[shortcut.to], shortcut.from, shortcut.weight, v))
+                {
+                    stale[shortcut.to] = 1;
+                }
+            }
+
+            upArcs[v].swap(outArcs[v]);
+            downArcs[v].swap(inArcs[v]);
+            excluded[v] = 0;
+        }
+
+        remaining.erase(
+            std::remove_if(remaining.begin(), remaining.end(), [&](int v) { return chosen[v] != 0; }),
+            remaining.end());
+
+        // The neighbors' priorities are brought up to date with the arcs
+        // and neighbors they've lost, keeping their estimates.
+        for (int v : neighbors)
+        {
+            changed[v] = 0;
+            prioritize(v);
+        }
+    }
+
+    auto pack = [&](const std::vector<std::vector<Arc>>& arcs, Arcs& packed)
+    {
+        packed.offsets.assign(1, 0);
+
+        for (int v = 0; v < n; ++v)
+        {
+            for (const Arc& arc : arcs[v])
+            {
+                packed.ends.push_back(arc.end);
+                packed.weights.push_back(arc.weight);
+                packed.middles.push_back(arc.middle);
+            }
+
+            packed.offsets.push_back(static_cast<int>(packed.ends.size()));
+        }
+    };
+
+    pack(upArcs, up);
+    pack(downArcs, down);
+}
+
+
+inline void ContractionHierarchy::save(const std::string& path) const
+{
+    ContractionHierarchyFileHeader header;
+    std::memcpy(header.magic, contractionHierarchyFileMagic, sizeof(header.magic));
+    header.version = contractionHierarchyFileVersion;
+    header.byteOrder = digraphFileByteOrder;
+    header.vertexCount = numbers.size();
+    header.upCount = up.ends.size();
+    header.downCount = down.ends.size();
+
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+
+    auto write = [&](const void* bytes, std::size_t length)
+    {
+        out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(length));
+    };
+
+    auto writeArcs = [&](const Arcs& arcs)
+    {
+        write(arcs.offsets.data(), arcs.offsets.size() * sizeof(int));
+        write(arcs.ends.data(), arcs.ends.size() * sizeof(int));
+        write(arcs.weights.data(), arcs.weights.size() * sizeof(double));
+        write(arcs.middles.data(), arcs.middles.size() * sizeof(int));
+    };
+
+    write(&header, sizeof(header));
+    write(numbers.data(), numbers.size() * sizeof(int));
+    writeArcs(up);
+    writeArcs(down);
+    out.close();
+
+    if (out.fail())
+    {
+        throw DigraphException("Could not write " + path);
+    }
+}
+
+
+inline ContractionHierarchy ContractionHierarchy::load(const std::string& path)
+{
+    std::ifstream in{path, std::ios::binary};
+
+    if (!in)
+    {
+        throw DigraphException("Could not read " + path);
+    }
+
+    auto corrupt = [&]()
+    {
+        return DigraphException(path + ": contraction hierarchy file is corrupt");
+    };
+
+    ContractionHierarchyFileHeader header;
+
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, contractionHierarchyFileMagic, sizeof(header.magic)) != 0)
+    {
+        throw DigraphException(path + ": not a contraction hierarchy file");
+    }
+
+    if (header.version != contractionHierarchyFileVersion)
+    {
+        throw DigraphException(path + ": unsupported contraction hierarchy file version");
+    }
+
+    if (header.byteOrder != digraphFileByteOrder)
+    {
+        throw DigraphException(path + ": contraction hierarchy file was written with a different byte order");
+    }
+
+    const std::uint64_t most = std::numeric_limits<int>::max();
+
+    if (header.vertexCount >= most || header.upCount > most || header.downCount > most)
+    {
+        throw corrupt();
+    }
+
+    int n = static_cast<int>(header.vertexCount);
+
+    // The sizes are checked against the file's before anything is
+    // allocated, so a corrupt header can't ask for a huge allocation.
+    std::streamoff start = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::uint64_t available = static_cast<std::uint64_t>(in.tellg() - start);
+    in.seekg(start);
+
+    std::uint64_t arcSize = 2 * sizeof(int) + sizeof(double);
+    std::uint64_t expected = (3 * header.vertexCount + 2) * sizeof(int)
+        + (header.upCount + header.downCount) * arcSize;
+
+    if (available != expected)
+    {
+        throw corrupt();
+    }
+
+    ContractionHierarchy hierarchy;
+
+    auto read = [&](void* bytes, std::size_t length)
+    {
+        if (!in.read(static_cast<char*>(bytes), static_cast<std::streamsize>(length)))
+        {
+            throw corrupt();
+        }
+    };
+
+    auto readArcs = [&](Arcs& arcs, std::uint64_t count)
+    {
+        arcs.offsets.resize(n + 1);
+        arcs.ends.resize(count);
+        arcs.weights.resize(count);
+        arcs.middles.resize(count);
+        read(arcs.offsets.data(), arcs.offsets.size() * sizeof(int));
+        read(arcs.ends.data(), arcs.ends.size() * sizeof(int));
+        read(arcs.weights.data(), arcs.weights.size() * sizeof(double));
+        read(arcs.middles.data(), arcs.middles.size() * sizeof(int));
+
+        if (arcs.offsets[0] != 0 || arcs.offsets[n] != static_cast<int>(count))
+        {
+            throw corrupt();
+        }
+
+        for (int v = 0; v < n; ++v)
+        {
+            if (arcs.offsets[v] > arcs.offsets[v + 1])
+            {
+                throw corrupt();
+            }
+        }
+
+        for (std::size_t a = 0; a < count; ++a)
+        {
+            if (arcs.ends[a] < 0 || arcs.ends[a] >= n || arcs.middles[a] < -1 || arcs.middles[a] >= n)
+            {
+                throw corrupt();
+            }
+        }
+    };
+
+    hierarchy.numbers.resize(n);
+    read(hierarchy.numbers.data(), hierarchy.numbers.size() * sizeof(int));
+    readArcs(hierarchy.up, header.upCount);
+    readArcs(hierarchy.down, header.downCount);
+
+    return hierarchy;
+}
+
+
+inline int ContractionHierarchy::vertexCount() const noexcept
+{
+    return static_cast<int>(numbers.size());
+}
+
+
+inline int ContractionHierarchy::edgeCount() const noexcept
+{
+    return static_cast<int>(up.ends.size() + down.ends.size());
+}
+
+
+inline double ContractionHierarchy::distance(int fromVertex, int toVertex, Query& query) const
+{
+    double cost;
+    int settled;
+    search(indexOf(fromVertex), indexOf(toVertex), query, cost, settled);
+    return cost;
+}
+
+
+inline double ContractionHierarchy::distance(int fromVertex, int toVertex) const
+{
+    Query query;
+    return distance(fromVertex, toVertex, query);
+}
+
+
+inline DigraphRoute ContractionHierarchy::route(int fromVertex, int toVertex, Query& query) const
+{
+    DigraphRoute route{std::vector<int>{}, 0.0, 0};
+    int from = indexOf(fromVertex);
+    int meeting = search(from, indexOf(toVertex), query, route.cost, route.settled);
+
+    if (meeting < 0)
+    {
+        return route;
+    }
+
+    // The forward search's parents lead from the meeting point back
+    // down to the start, and the backward search's lead from it down
+    // to the end.  Each parent is the index of the arc that was
+    // followed; the vertex it belongs to is found from the offsets.
+    std::vector<int> arcs;
+
+    for (int v = meeting; v != from; )
+    {
+        int a = query.parent[0][v];
+        arcs.push_back(a);
+        v = static_cast<int>(std::upper_bound(up.offsets.begin(), up.offsets.end(), a) - up.offsets.begin()) - 1;
+    }
+
+    route.path.push_back(numbers[from]);
+
+    for (auto a = arcs.rbegin(); a != arcs.rend(); ++a)
+    {
+        int u = static_cast<int>(std::upper_bound(up.offsets.begin(), up.offsets.end(), *a) - up.offsets.begin()) - 1;
+        unpack(u, up.ends[*a], up.middles[*a], route.path);
+    }
+
+    for (int v = meeting; query.parent[1][v] >= 0; )
+    {
+        int a = query.parent[1][v];
+        int w = static_cast<int>(std::upper_bound(down.offsets.begin(), down.offsets.end(), a) - down.offsets.begin()) - 1;
+        unpack(v, w, down.middles[a], route.path);
+        v = w;
+    }
+
+    return route;
+}
+
+
+inline DigraphRoute ContractionHierarchy::route(int fromVertex, int toVertex) const
+{
+    Query query;
+    return route(fromVertex, toVertex, query);
+}
+
+
+inline int ContractionHierarchy::indexOf(int vertex) const
+{
+    auto i = std::lower_bound(numbers.begin(), numbers.end(), vertex);
+
+    if (i == numbers.end() || *i != vertex)
+    {
+        throw DigraphException("Vertex " + std::to_string(vertex) + " does not exist");
+    }
+
+    return static_cast<int>(i - numbers.begin());
+}
+
+
+inline int ContractionHierarchy::search(int from, int to, Query& query, double& cost, int& settled) const
+{
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    int n = vertexCount();
+    const Arcs* arcs[2] = {&up, &down};
+
+    for (int side = 0; side < 2; ++side)
+    {
+        if (static_cast<int>(query.distance[side].size()) != n)
+        {
+            query.distance[side].assign(n, infinity);
+            query.parent[side].assign(n, -1);
+        }
+        else
+        {
+            for (int v : query.touched[side])
+            {
+                query.distance[side][v] = infinity;
+                query.parent[side][v] = -1;
+            }
+        }
+
+        query.touched[side].clear();
+        query.heap[side].reset(n);
+    }
+
+    query.distance[0][from] = 0.0;
+    query.distance[1][to] = 0.0;
+    query.touched[0].push_back(from);
+    query.touched[1].push_back(to);
+    query.heap[0].push(from, 0.0);
+    query.heap[1].push(to, 0.0);
+
+    cost = infinity;
+    settled = 0;
+    int meeting = -1;
+
+    // A search stops once nothing left in its heap could lead to a
+    // shorter path than the best one found so far.
+    auto running = [&](int side)
+    {
+        return !query.heap[side].empty() && query.heap[side].topPriority() < cost;
+    };
+
+    for (int side = 0; running(0) || running(1); side = 1 - side)
+    {
+        if (!running(side))
+        {
+            continue;
+        }
+
+        std::vector<double>& distance = query.distance[side];
+        double d = query.heap[side].topPriority();
+        int u = query.heap[side].pop();
+        ++settled;
+
+        DIGRAPH_STATS_ADD(verticesSettled, 1);
+
+        if (d + query.distance[1 - side][u] < cost)
+        {
+            cost = d + query.distance[1 - side][u];
+            meeting = u;
+        }
+
+        // Stall on demand: the arcs of u in the other direction lead to
+        // higher-ranked vertices this search may also have reached.  If
+        // one of them has a shorter path to u than d, then d isn't u's
+        // real distance, and nothing reached through u can be on a
+        // shortest path, so u's arcs aren't followed.
+        const Arcs& other = *arcs[1 - side];
+        bool stalled = false;
+
+        for (int e = other.offsets[u]; e < other.offsets[u + 1] && !stalled; ++e)
+        {
+            stalled = distance[other.ends[e]] + other.weights[e] < d;
+        }
+
+        if (stalled)
+        {
+            continue;
+        }
+
+        const Arcs& a = *arcs[side];
+
+        DIGRAPH_STATS_ADD(edgesRelaxed, a.offsets[u + 1] - a.offsets[u]);
+
+        for (int e = a.offsets[u]; e < a.offsets[u + 1]; ++e)
+        {
+            int v = a.ends[e];
+            double candidate = d + a.weights[e];
+
+            if (candidate < distance[v])
+            {
+                if (distance[v] == infinity)
+                {
+                    query.touched[side].push_back(v);
+                }
+
+                distance[v] = candidate;
+                query.parent[side][v] = e;
+                query.heap[side].pushOrDecrease(v, candidate);
+            }
+        }
+    }
+
+    return meeting;
+}
+
+
+inline void ContractionHierarchy::unpack(int from, int to, int middle, std::vector<int>& path) const
+{
+    if (middle < 0)
+    {
+        path.push_back(numbers[to]);
+        return;
+    }
+
+    // Both halves of a shortcut are arcs of its middle vertex, which
+    // ranks below both of its ends: the first half is a down arc and
+    // the second an up arc.
+    auto find = [&](const Arcs& arcs, int end)
+    {
+        int best = -1;
+
+        for (int a = arcs.offsets[middle]; a < arcs.offsets[middle + 1]; ++a)
+        {
+            if (arcs.ends[a] == end && (best < 0 || arcs.weights[a] < arcs.weights[best]))
+            {
+                best = a;
+            }
+        }
+
+        return best;
+    };
+
+    unpack(from, middle, down.middles[find(down, from)], path);
+    unpack(middle, to, up.middles[find(up, to)], path);
+}
+
+
+
+#endif // CONTRACTIONHIERARCHY_HPP
@@ -20,14 +20,27 @@
 #ifndef DIGRAPH_HPP
 #define DIGRAPH_HPP
 
+#include <algorithm>
+#include <cstddef>
 #include <exception>
 #include <functional>
+#include <iterator>
 #include <list>
 #include <map>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
-#include <queue>
 #include <iostream>
+#include "DigraphBfs.hpp"
+#include "DigraphCsr.hpp"
+#include "DigraphDeltaStepping.hpp"
+#include "DigraphFile.hpp"
+#include "DigraphRoute.hpp"
+#include "DigraphShortestPaths.hpp"
+#include "DigraphStats.hpp"
+#include "EdgeIndex.hpp"
+#include "MappedFile.hpp"
 
 // DigraphExceptions are thrown from some of the member functions in the
 // Digraph class template, so that exception is declared here, so it
@@ -62,40 +75,209 @@ struct DigraphEdge
 
 
 
-// A DigraphVertex includes two things: a VertexInfo object and a list of
-// its outgoing edges.  Because different kinds of Digraphs store different
-// kinds of vertex and edge information, DigraphVertex is a struct template.
+// A DigraphVertex includes three things: a VertexInfo object, a list of
+// its outgoing edges, and the vertex numbers of the vertices its incoming
+// edges come from (in no particular order).  Because different kinds of
+// Digraphs store different kinds of vertex and edge information,
+// DigraphVertex is a struct template.  Its containers allocate memory
+// with (rebound copies of) the Digraph's Allocator.
 
-template <typename VertexInfo, typename EdgeInfo>
+template <typename VertexInfo, typename EdgeInfo, typename Allocator = std::allocator<char>>
 struct DigraphVertex
 {
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<DigraphEdge<EdgeInfo>> EdgeAllocator;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<int> IncomingAllocator;
+    typedef std::list<DigraphEdge<EdgeInfo>, EdgeAllocator> EdgeList;
+    typedef std::vector<int, IncomingAllocator> IncomingList;
+
     VertexInfo vinfo;
-    std::list<DigraphEdge<EdgeInfo>> edges;
+    EdgeList edges;
+    IncomingList incoming;
+};
+
+
+
+// A DigraphVertexMap is the std::map in which a Digraph keeps its
+// vertices, keyed by vertex number.
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator = std::allocator<char>>
+using DigraphVertexMap = std::map<
+    int, DigraphVertex<VertexInfo, EdgeInfo, Allocator>, std::less<int>,
+    typename std::allocator_traits<Allocator>::template rebind_alloc<
+        std::pair<const int, DigraphVertex<VertexInfo, EdgeInfo, Allocator>>>>;
+
+
+
+// A DigraphRange is a pair of iterators that can be used in a range-based
+// for loop.  Digraph returns them from the member functions that walk its
+// vertices and edges in place, without copying anything.
+
+template <typename Iterator>
+struct DigraphRange
+{
+    Iterator first;
+    Iterator last;
+
+    Iterator begin() const { return first; }
+    Iterator end() const { return last; }
+    bool empty() const { return first == last; }
+};
+
+
+
+// A DigraphEdgeIterator walks every edge of a Digraph, one vertex's edge
+// list after another.  It's a forward iterator whose elements are the
+// DigraphEdge objects stored in the Digraph.
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator = std::allocator<char>>
+class DigraphEdgeIterator
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef DigraphEdge<EdgeInfo> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const DigraphEdge<EdgeInfo>* pointer;
+    typedef const DigraphEdge<EdgeInfo>& reference;
+
+    typedef typename DigraphVertexMap<VertexInfo, EdgeInfo, Allocator>::const_iterator VertexIterator;
+
+    DigraphEdgeIterator(VertexIterator vertex, VertexIterator lastVertex);
+
+    reference operator*() const;
+    pointer operator->() const;
+    DigraphEdgeIterator& operator++();
+    DigraphEdgeIterator operator++(int);
+    bool operator==(const DigraphEdgeIterator& other) const;
+    bool operator!=(const DigraphEdgeIterator& other) const;
+
+
+private:
+    VertexIterator vertex;
+    VertexIterator lastVertex;
+    typename DigraphVertex<VertexInfo, EdgeInfo, Allocator>::EdgeList::const_iterator edge;
+
+    void skipEmptyVertices();
 };
 
 
 
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::DigraphEdgeIterator(VertexIterator vertex, VertexIterator lastVertex)
+    : vertex{vertex}, lastVertex{lastVertex}, edge{}
+{
+    if (vertex != lastVertex)
+    {
+        edge = vertex->second.edges.begin();
+        skipEmptyVertices();
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+typename DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::reference DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::operator*() const
+{
+    return *edge;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+typename DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::pointer DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::operator->() const
+{
+    return &*edge;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>& DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::operator++()
+{
+    ++edge;
+    skipEmptyVertices();
+    return *this;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator> DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::operator++(int)
+{
+    DigraphEdgeIterator old = *this;
+    ++*this;
+    return old;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+bool DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::operator==(const DigraphEdgeIterator& other) const
+{
+    return vertex == other.vertex && (vertex == lastVertex || edge == other.edge);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+bool DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::operator!=(const DigraphEdgeIterator& other) const
+{
+    return !(*this == other);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>::skipEmptyVertices()
+{
+    while (edge == vertex->second.edges.end())
+    {
+        if (++vertex == lastVertex)
+        {
+            return;
+        }
+
+        edge = vertex->second.edges.begin();
+    }
+}
+
+
+
 // Digraph is a class template that represents a directed graph implemented
 // using adjacency lists.  It takes two type parameters:
 //
 // * VertexInfo, which specifies the kind of object stored for each vertex
 // * EdgeInfo, which specifies the kind of object stored for each edge
 //
+// and, optionally, a third:
+//
+// * Allocator, which specifies where the nodes of the vertex map and
+//   the edge lists get their memory (std::allocator by default; see
+//   DigraphPool.hpp for a pool that makes building and destroying big
+//   graphs much cheaper)
+//
 // You'll need to implement the member functions declared here; each has a
 // comment detailing how it is intended to work.
 //
 // Each vertex in a Digraph is identified uniquely by a "vertex number".
 // Vertex numbers are not necessarily sequential and they are not necessarily
 // zero- or one-based.
+//
+// A Digraph that is built once and then only queried can be packed
+// into a FrozenDigraph (see FrozenDigraph.hpp), which answers the same
+// queries from contiguous arrays.
 
 template <typename VertexInfo, typename EdgeInfo>
+class FrozenDigraph;
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator = std::allocator<char>>
 class Digraph
 {
 public:
+    typedef DigraphVertexMap<VertexInfo, EdgeInfo, Allocator> VertexMap;
+    typedef typename DigraphVertex<VertexInfo, EdgeInfo, Allocator>::EdgeList EdgeList;
+    typedef typename DigraphVertex<VertexInfo, EdgeInfo, Allocator>::IncomingList IncomingList;
+
     // The default constructor initializes a new, empty Digraph so that
     // contains no vertices and no edges.
     Digraph();
 
+    // This constructor initializes a new, empty Digraph whose vertices
+    // and edges will be allocated with the given allocator.
+    explicit Digraph(const Allocator& alloc);
+
     // The copy constructor initializes a new Digraph to be a deep copy
     // of another one (i.e., any change to the copy will not affect the
     // original).
@@ -144,6 +326,31 @@ public:
     // DigraphException is thrown instead.
     EdgeInfo edgeInfo(int fromVertex, int toVertex) const;
 
+    // The member functions below are the allocation-free counterparts
+    // of the ones above.  Rather than building a std::vector or copying
+    // an info object, they refer to what's stored in the Digraph, so
+    // what they return is only good until the Digraph next changes.
+    //
+    // * allVertices() is a range of (vertex number, DigraphVertex)
+    //   pairs, in ascending order of vertex number
+    // * allEdges() is a range of every DigraphEdge, in the same order
+    //   as edges()
+    // * outEdges() is a range of the DigraphEdges outgoing from the
+    //   given vertex, in the same order as edges(vertex)
+    // * inVertices() is a range of the vertex numbers of the vertices
+    //   with edges into the given vertex, in the same order as
+    //   inEdges(vertex)
+    // * vertexInfoRef() and edgeInfoRef() refer to the VertexInfo and
+    //   EdgeInfo objects that vertexInfo() and edgeInfo() would copy
+    //
+    // They throw the same DigraphExceptions as their counterparts.
+    DigraphRange<typename VertexMap::const_iterator> allVertices() const;
+    DigraphRange<DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>> allEdges() const;
+    DigraphRange<typename EdgeList::const_iterator> outEdges(int vertex) const;
+    DigraphRange<typename IncomingList::const_iterator> inVertices(int vertex) const;
+    const VertexInfo& vertexInfoRef(int vertex) const;
+    const EdgeInfo& edgeInfoRef(int fromVertex, int toVertex) const;
+
     // addVertex() adds a vertex to the Digraph with the given vertex
     // number and VertexInfo object.  If there is already a vertex in
     // the graph with the given vertex number, a DigraphException is
@@ -170,6 +377,25 @@ public:
     // thrown instead.
     void removeEdge(int fromVertex, int toVertex);
 
+    // setEdgeInfo() replaces the EdgeInfo object belonging to the edge
+    // with the given "from" and "to" vertex numbers, leaving the edge
+    // where it is.  If either of those vertices does not exist *or* if
+    // the edge does not exist, a DigraphException is thrown instead.
+    void setEdgeInfo(int fromVertex, int toVertex, const EdgeInfo& einfo);
+
+    // addVertices(), addEdges() and removeEdges() apply a whole batch of
+    // changes at once.  Each has the same effect, and throws the same
+    // DigraphException, as calling addVertex(), addEdge() or
+    // removeEdge() once per element in order would, except that the
+    // batch is all or nothing: if any element would throw, the Digraph
+    // is left unchanged.  The batch is checked up front, sorted by
+    // "from" vertex so that each vertex is looked up once per batch
+    // rather than once per edge, and room for all of it is made before
+    // any of it is applied.
+    void addVertices(const std::vector<std::pair<int, VertexInfo>>& batch);
+    void addEdges(const std::vector<DigraphEdge<EdgeInfo>>& batch);
+    void removeEdges(const std::vector<std::pair<int, int>>& batch);
+
     // vertexCount() returns the number of vertices in the graph.
     int vertexCount() const noexcept;
 
@@ -183,11 +409,55 @@ public:
     // thrown instead.
     int edgeCount(int vertex) const;
 
+    // inEdges() returns a std::vector of std::pairs, in which each pair
+    // contains the "from" and "to" vertex numbers of an edge in this
+    // Digraph that points to the given vertex number, in no particular
+    // order.  If the given vertex does not exist, a DigraphException is
+    // thrown instead.
+    std::vector<std::pair<int, int>> inEdges(int vertex) const;
+
+    // inDegree() returns the number of edges in the graph that are
+    // incoming to the given vertex number.  If the given vertex does
+    // not exist, a DigraphException is thrown instead.
+    //
+    // All of the counts are kept up to date as the graph changes, so
+    // asking for them takes constant time and allocates nothing.
+    int inDegree(int vertex) const;
+
     // isStronglyConnected() returns true if the Digraph is strongly
     // connected (i.e., every vertex is reachable from every other),
     // false otherwise.
     bool isStronglyConnected() const;
 
+    // stronglyConnectedComponents() returns the strongly connected
+    // components of the Digraph, along with its condensation DAG (see
+    // DigraphComponents in DigraphCsr.hpp).
+    DigraphComponents stronglyConnectedComponents() const;
+
+    // breadthFirstSearch() searches the Digraph breadth-first from the
+    // given start vertex, spreading the work over the given number of
+    // threads (or, if it's zero, one per hardware thread), and returns
+    // the level and BFS-tree parent of every vertex (see DigraphBfsTree
+    // in DigraphBfs.hpp).  If the start vertex does not exist, a
+    // DigraphException is thrown instead.
+    DigraphBfsTree breadthFirstSearch(int startVertex, unsigned threads = 0) const;
+
+    // depthFirstSearch() searches the Digraph depth-first from the
+    // given start vertex, calling preVisit(v) with each vertex number v
+    // as the search first reaches it and postVisit(v) once everything
+    // reachable from v has been finished.  The search keeps its own
+    // stack, so it does not recurse however deep the graph is.  If the
+    // start vertex does not exist, a DigraphException is thrown instead.
+    template <typename PreVisit, typename PostVisit>
+    void depthFirstSearch(int startVertex, PreVisit&& preVisit, PostVisit&& postVisit) const;
+
+    // depthFirstTraversal() searches the whole Digraph depth-first,
+    // starting a new search from each vertex that hasn't been reached
+    // yet in ascending order of vertex number, and calls the visitors
+    // the same way depthFirstSearch() does.
+    template <typename PreVisit, typename PostVisit>
+    void depthFirstTraversal(PreVisit&& preVisit, PostVisit&& postVisit) const;
+
     // findShortestPaths() takes a start vertex number and a function
     // that takes an EdgeInfo object and determines an edge weight.
     // It uses Dijkstra's Shortest Path Algorithm to determine the
@@ -197,25 +467,157 @@ public:
     // with each key k is the precedessor of that vertex chosen by
     // the algorithm.  For any vertex without a predecessor (e.g.,
     // a vertex that was never reached, or the start vertex itself),
-    // the value is simply a copy of the key.
+    // the value is simply a copy of the key.  Edge weights must not be
+    // negative.  If the start vertex does not exist, a DigraphException
+    // is thrown instead.
     std::map<int, int> findShortestPaths(
         int startVertex,
         std::function<double(const EdgeInfo&)> edgeWeightFunc) const;
 
+    // This overload of findShortestPaths() also fills in the given
+    // std::map with the length of the shortest path to every vertex;
+    // unreachable vertices have a distance of infinity.
+    std::map<int, int> findShortestPaths(
+        int startVertex,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc,
+        std::map<int, double>& distances) const;
+
+    // These overloads of findShortestPaths() accept any callable as the
+    // weight function, rather than a std::function, so that calls to it
+    // can be inlined into the search.
+    template <typename WeightFn>
+    std::map<int, int> findShortestPaths(int startVertex, WeightFn&& edgeWeightFunc) const;
+
+    template <typename WeightFn>
+    std::map<int, int> findShortestPaths(
+        int startVertex, WeightFn&& edgeWeightFunc,
+        std::map<int, double>& distances) const;
+
+    // findShortestPathsMany() finds the shortest paths from each of the
+    // given start vertices, as findShortestPaths() would, but runs the
+    // searches in parallel on the given number of threads (or, if it's
+    // zero, one per hardware thread) and returns them all in one
+    // DigraphPathMatrix (see DigraphShortestPaths.hpp).  The weight of
+    // each edge is worked out once, up front, rather than once per
+    // search.  If any of the start vertices does not exist, a
+    // DigraphException is thrown instead.
+    DigraphPathMatrix findShortestPathsMany(
+        const std::vector<int>& startVertices,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc,
+        unsigned threads = 0) const;
+
+    // findShortestPathsParallel() finds the shortest paths from the
+    // given start vertex, returning them just as findShortestPaths()
+    // does, but spreads a single search over the given number of
+    // threads (or, if it's zero, one per hardware thread) using
+    // delta-stepping, with buckets of width delta (or, if it's zero,
+    // a width worked out from the edge weights; see
+    // DigraphDeltaStepping.hpp).  It pays off on graphs with hundreds
+    // of thousands of vertices or more; smaller ones are searched on
+    // one thread.  The distances are the same ones findShortestPaths()
+    // finds, and so are the predecessors of vertices with only one
+    // shortest path; a vertex with several may be given a predecessor
+    // on a different one.  If the start vertex does not exist, a
+    // DigraphException is thrown instead.
+    std::map<int, int> findShortestPathsParallel(
+        int startVertex,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc,
+        double delta = 0.0, unsigned threads = 0) const;
+
+    std::map<int, int> findShortestPathsParallel(
+        int startVertex,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc,
+        std::map<int, double>& distances,
+        double delta = 0.0, unsigned threads = 0) const;
+
+    // shortestPath() finds a shortest path from one vertex to another,
+    // returning it along with its cost (see DigraphRoute.hpp), and
+    // stops as soon as it knows the answer instead of working out the
+    // paths to every vertex.  Without a heuristic function, it searches
+    // forward from fromVertex and backward from toVertex at once.  With
+    // one, it runs A*: heuristicFunc(vinfo, targetInfo) must return a
+    // lower bound on the length of a path from the vertex with info
+    // vinfo to the one with info targetInfo (the straight-line distance
+    // between their coordinates, say), and must be consistent, never
+    // dropping by more than an edge's weight from one end of it to the
+    // other.  If either vertex does not exist, a DigraphException is
+    // thrown instead.
+    template <typename WeightFn>
+    DigraphRoute shortestPath(int fromVertex, int toVertex, WeightFn&& edgeWeightFunc) const;
+
+    template <typename WeightFn, typename HeuristicFn>
+    DigraphRoute shortestPath(
+        int fromVertex, int toVertex, WeightFn&& edgeWeightFunc,
+        HeuristicFn&& heuristicFunc) const;
+
+    // save() writes the Digraph to the file with the given path in the
+    // binary format described in DigraphFile.hpp, and load() builds a
+    // new Digraph from such a file.  Both throw a DigraphException if
+    // the file can't be written or read.  Only Digraphs with trivially
+    // copyable VertexInfo and EdgeInfo can be saved and loaded.  (A
+    // FrozenDigraph can load the same file without building anything.)
+    void save(const std::string& path) const;
+    static Digraph load(const std::string& path, const Allocator& alloc = Allocator());
+
 
 private:
     // Add whatever member variables you think you need here.  One
     // possibility is a std::map where the keys are vertex numbers
-    // and the values are DigraphVertex<VertexInfo, EdgeInfo> objects.
+    // and the values are DigraphVertex<VertexInfo, EdgeInfo, Allocator> objects.
 
 
     // You can also feel free to add any additional member functions
     // you'd like (public or private), so long as you don't remove or
     // change the signatures of the ones that already exist.
-    std::map<int, DigraphVertex<VertexInfo, EdgeInfo>> vmap;
+    VertexMap vmap;
+    int edge_count;
+
+    // eindex finds, in constant expected time, each edge's node in its
+    // "from" vertex's edge list and its position in its "to" vertex's
+    // incoming vector.  Copies of a Digraph get new lists, so they
+    // rebuild the index with rebuildEdgeIndex().
+    typedef typename EdgeList::iterator EdgeNode;
+
+    struct EdgeSlot
+    {
+        EdgeNode edge;
+        int incomingSlot;
+    };
+
+    EdgeIndex<EdgeSlot> eindex;
+
+    void rebuildEdgeIndex();
 
+    typedef typename VertexMap::iterator VertexNode;
+
+    // newVertex() returns an unconnected vertex with the given info,
+    // allocated the same way as the rest of the Digraph.
+    DigraphVertex<VertexInfo, EdgeInfo, Allocator> newVertex(const VertexInfo& vinfo) const;
+
+    // linkEdge() adds an edge between two vertices already known to
+    // exist and not yet connected; if it throws, nothing changes.
+    // unlinkEdge() removes the edge with the given slot.
+    void linkEdge(VertexNode from, VertexNode to, const EdgeInfo& einfo);
+    void unlinkEdge(VertexNode from, VertexNode to, EdgeSlot* edge);
+
+    // unlinkIncoming() removes the edge with the given slot from its
+    // "to" vertex's incoming vector, leaving its edge list alone.
+    void unlinkIncoming(DigraphVertex<VertexInfo, EdgeInfo, Allocator>& to, int toVertex, int slot);
     void checkVertexExistence(int vertex) const;
-    void dft(std::vector<int>& vertex_list, const std::pair<int, DigraphVertex<VertexInfo, EdgeInfo>>& vertex) const;
+
+    friend class FrozenDigraph<VertexInfo, EdgeInfo>;
+
+    // buildCsr() packs the current topology into csr and, if einfos is
+    // given, stores in it a pointer to the EdgeInfo of each edge in the
+    // same order as csr.targets.
+    void buildCsr(DigraphCsr& csr, std::vector<const EdgeInfo*>* einfos = nullptr) const;
+
+    // shortestPaths() is what every overload of findShortestPaths()
+    // runs.
+    template <typename WeightFn>
+    std::map<int, int> shortestPaths(
+        int startVertex, const WeightFn& edgeWeightFunc,
+        std::map<int, double>& distances) const;
 
 
 };
@@ -226,61 +628,76 @@ private:
 // code in place to make them compile, but they'll all need to do the
 // correct thing instead.
 
-template <typename VertexInfo, typename EdgeInfo>
-Digraph<VertexInfo, EdgeInfo>::Digraph()
-    : vmap{std::map<int, DigraphVertex<VertexInfo, EdgeInfo>>()}
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+Digraph<VertexInfo, EdgeInfo, Allocator>::Digraph()
+    : Digraph{Allocator()}
 {
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-Digraph<VertexInfo, EdgeInfo>::Digraph(const Digraph& d)
-    : vmap{d.vmap}
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+Digraph<VertexInfo, EdgeInfo, Allocator>::Digraph(const Allocator& alloc)
+    : vmap{typename VertexMap::allocator_type(alloc)}, edge_count{0}, eindex{}
 {
 }
 
-template <typename VertexInfo, typename EdgeInfo>
-Digraph<VertexInfo, EdgeInfo>::Digraph(Digraph&& d) noexcept
-    : vmap{std::map<int, DigraphVertex<VertexInfo, EdgeInfo>>()}
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+Digraph<VertexInfo, EdgeInfo, Allocator>::Digraph(const Digraph& d)
+    : vmap{d.vmap}, edge_count{d.edge_count}, eindex{}
+{
+    rebuildEdgeIndex();
+}
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+Digraph<VertexInfo, EdgeInfo, Allocator>::Digraph(Digraph&& d) noexcept
+    : vmap{std::move(d.vmap)}, edge_count{0}, eindex{}
 {
-    std::swap(vmap, d.vmap);
+    d.vmap.clear();
+    std::swap(edge_count, d.edge_count);
+    std::swap(eindex, d.eindex);
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-Digraph<VertexInfo, EdgeInfo>::~Digraph() noexcept
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+Digraph<VertexInfo, EdgeInfo, Allocator>::~Digraph() noexcept
 {
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-Digraph<VertexInfo, EdgeInfo>& Digraph<VertexInfo, EdgeInfo>::operator=(const Digraph& d)
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+Digraph<VertexInfo, EdgeInfo, Allocator>& Digraph<VertexInfo, EdgeInfo, Allocator>::operator=(const Digraph& d)
 {
     if (this != &d)
     {
         vmap = d.vmap;
+        edge_count = d.edge_count;
+        rebuildEdgeIndex();
     }
 
     return *this;
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-Digraph<VertexInfo, EdgeInfo>& Digraph<VertexInfo, EdgeInfo>::operator=(Digraph&& d) noexcept
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+Digraph<VertexInfo, EdgeInfo, Allocator>& Digraph<VertexInfo, EdgeInfo, Allocator>::operator=(Digraph&& d) noexcept
 {
     if (this != &d)
     {
         std::swap(vmap, d.vmap);
+        std::swap(edge_count, d.edge_count);
+        std::swap(eindex, d.eindex);
     }
 
     return *this;
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-std::vector<int> Digraph<VertexInfo, EdgeInfo>::vertices() const
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::vector<int> Digraph<VertexInfo, EdgeInfo, Allocator>::vertices() const
 {
     std::vector<int> v_list;
+    v_list.reserve(vmap.size());
     for (auto const& i : vmap)
     {
         v_list.push_back(i.first);
@@ -289,30 +706,26 @@ std::vector<int> Digraph<VertexInfo, EdgeInfo>::vertices() const
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-std::vector<std::pair<int, int>> Digraph<VertexInfo, EdgeInfo>::edges() const
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::vector<std::pair<int, int>> Digraph<VertexInfo, EdgeInfo, Allocator>::edges() const
 {
+    // addEdge() never lets the same edge in twice, so every edge can be
+    // listed as it's found.
     std::vector<std::pair<int, int>> e_list;
-    for (auto const& i : vmap)
+    e_list.reserve(edge_count);
+    for (auto const& x : allEdges())
     {
-        for (auto const& x : i.second.edges)
-        {
-            if (std::find(e_list.begin(), e_list.end(), std::pair<int, int>{x.fromVertex, x.toVertex}) == e_list.end())
-            {
-                e_list.push_back(std::pair<int, int>{x.fromVertex, x.toVertex});
-            }
-        }
-    } 
+        e_list.push_back(std::pair<int, int>{x.fromVertex, x.toVertex});
+    }
     return e_list;
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-std::vector<std::pair<int, int>> Digraph<VertexInfo, EdgeInfo>::edges(int vertex) const
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::vector<std::pair<int, int>> Digraph<VertexInfo, EdgeInfo, Allocator>::edges(int vertex) const
 {
-    checkVertexExistence(vertex);
     std::vector<std::pair<int, int>> e_list;
-    for (auto const& i : vmap.find(vertex)->second.edges)
+    for (auto const& i : outEdges(vertex))
     {
         e_list.push_back(std::pair<int, int>{i.fromVertex, i.toVertex});
     }
@@ -320,199 +733,920 @@ std::vector<std::pair<int, int>> Digraph<VertexInfo, EdgeInfo>::edges(int vertex
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-VertexInfo Digraph<VertexInfo, EdgeInfo>::vertexInfo(int vertex) const
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+VertexInfo Digraph<VertexInfo, EdgeInfo, Allocator>::vertexInfo(int vertex) const
+{
+    return vertexInfoRef(vertex);
+}
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+EdgeInfo Digraph<VertexInfo, EdgeInfo, Allocator>::edgeInfo(int fromVertex, int toVertex) const
+{
+    return edgeInfoRef(fromVertex, toVertex);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphRange<typename Digraph<VertexInfo, EdgeInfo, Allocator>::VertexMap::const_iterator>
+Digraph<VertexInfo, EdgeInfo, Allocator>::allVertices() const
+{
+    return {vmap.begin(), vmap.end()};
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphRange<DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>> Digraph<VertexInfo, EdgeInfo, Allocator>::allEdges() const
+{
+    return {DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>{vmap.begin(), vmap.end()},
+            DigraphEdgeIterator<VertexInfo, EdgeInfo, Allocator>{vmap.end(), vmap.end()}};
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphRange<typename Digraph<VertexInfo, EdgeInfo, Allocator>::EdgeList::const_iterator>
+Digraph<VertexInfo, EdgeInfo, Allocator>::outEdges(int vertex) const
+{
+    checkVertexExistence(vertex);
+    auto const& edges = vmap.find(vertex)->second.edges;
+    return {edges.begin(), edges.end()};
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphRange<typename Digraph<VertexInfo, EdgeInfo, Allocator>::IncomingList::const_iterator>
+Digraph<VertexInfo, EdgeInfo, Allocator>::inVertices(int vertex) const
+{
+    checkVertexExistence(vertex);
+    auto const& incoming = vmap.find(vertex)->second.incoming;
+    return {incoming.begin(), incoming.end()};
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+const VertexInfo& Digraph<VertexInfo, EdgeInfo, Allocator>::vertexInfoRef(int vertex) const
 {
     checkVertexExistence(vertex);
     return vmap.find(vertex)->second.vinfo;
 }
 
-template <typename VertexInfo, typename EdgeInfo>
-EdgeInfo Digraph<VertexInfo, EdgeInfo>::edgeInfo(int fromVertex, int toVertex) const
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+const EdgeInfo& Digraph<VertexInfo, EdgeInfo, Allocator>::edgeInfoRef(int fromVertex, int toVertex) const
 {
+    const EdgeSlot* edge = eindex.find(fromVertex, toVertex);
+
+    if (edge != nullptr)
+    {
+        return edge->edge->einfo;
+    }
+
     checkVertexExistence(fromVertex);
     checkVertexExistence(toVertex);
-    for (auto const& i : vmap)
+    throw DigraphException("Edge does not exist");
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::addVertex(int vertex, const VertexInfo& vinfo)
+{
+    if (vmap.find(vertex) != vmap.end())
     {
-        for (auto const& x : i.second.edges)
+        throw DigraphException("Vertex number already exists");
+    }
+
+    vmap.emplace(vertex, newVertex(vinfo));
+}
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::addEdge(int fromVertex, int toVertex, const EdgeInfo& einfo)
+{
+    auto from = vmap.find(fromVertex);
+    auto to = vmap.find(toVertex);
+
+    if (from == vmap.end() || to == vmap.end())
+    {
+        checkVertexExistence(fromVertex);
+        checkVertexExistence(toVertex);
+    }
+
+    if (eindex.find(fromVertex, toVertex) != nullptr)
+    {
+        throw DigraphException("Edge already exists");
+    }
+
+    linkEdge(from, to, einfo);
+}
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::removeVertex(int vertex)
+{
+    checkVertexExistence(vertex);
+
+    auto& removed = vmap[vertex];
+
+    // Only the vertex's own neighbours have to change: the vertices its
+    // outgoing edges point to lose an incoming edge, and the vertices its
+    // incoming edges come from lose an outgoing one.
+    for (auto const& e : removed.edges)
+    {
+        if (e.toVertex != vertex)
         {
-            if (x.fromVertex == fromVertex && x.toVertex == toVertex)
-            {
-                return x.einfo;
-            }
+            unlinkIncoming(vmap[e.toVertex], e.toVertex, eindex.find(vertex, e.toVertex)->incomingSlot);
         }
+
+        eindex.erase(vertex, e.toVertex);
+        --edge_count;
     }
-    throw DigraphException("Edge does not exist");
+
+    for (int from : removed.incoming)
+    {
+        if (from != vertex)
+        {
+            vmap[from].edges.erase(eindex.find(from, vertex)->edge);
+            eindex.erase(from, vertex);
+            --edge_count;
+        }
+    }
+
+    vmap.erase(vertex);
 }
 
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::removeEdge(int fromVertex, int toVertex)
+{
+    EdgeSlot* edge = eindex.find(fromVertex, toVertex);
 
-template <typename VertexInfo, typename EdgeInfo>
-void Digraph<VertexInfo, EdgeInfo>::addVertex(int vertex, const VertexInfo& vinfo)
+    if (edge == nullptr)
+    {
+        checkVertexExistence(fromVertex);
+        checkVertexExistence(toVertex);
+        throw DigraphException("Edge does not exist");
+    }
+
+    unlinkEdge(vmap.find(fromVertex), vmap.find(toVertex), edge);
+}
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::setEdgeInfo(int fromVertex, int toVertex, const EdgeInfo& einfo)
 {
-    if (vmap.find(vertex) != vmap.end())
+    EdgeSlot* edge = eindex.find(fromVertex, toVertex);
+
+    if (edge == nullptr)
+    {
+        checkVertexExistence(fromVertex);
+        checkVertexExistence(toVertex);
+        throw DigraphException("Edge does not exist");
+    }
+
+    edge->edge->einfo = einfo;
+}
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::addVertices(const std::vector<std::pair<int, VertexInfo>>& batch)
+{
+    int n = static_cast<int>(batch.size());
+
+    // Sorting by vertex number puts repeats next to each other (the
+    // first of them in the batch is the one that would succeed) and
+    // lets each insertion start from where the last one went.
+    std::vector<int> order(n);
+
+    for (int i = 0; i < n; ++i)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return batch[a].first != batch[b].first ? batch[a].first < batch[b].first : a < b;
+    });
+
+    int firstBad = n;
+
+    for (int k = 0; k < n; ++k)
+    {
+        int i = order[k];
+        bool repeated = k > 0 && batch[order[k - 1]].first == batch[i].first;
+
+        if (i < firstBad && (repeated || vmap.find(batch[i].first) != vmap.end()))
+        {
+            firstBad = i;
+        }
+    }
+
+    if (firstBad < n)
     {
         throw DigraphException("Vertex number already exists");
     }
-    vmap[vertex] = DigraphVertex<VertexInfo, EdgeInfo>{vinfo, std::list<DigraphEdge<EdgeInfo>>()};
+
+    std::vector<VertexNode> added;
+    added.reserve(n);
+
+    try
+    {
+        VertexNode hint = vmap.end();
+
+        for (int i : order)
+        {
+            hint = vmap.emplace_hint(hint, batch[i].first, newVertex(batch[i].second));
+            added.push_back(hint);
+            ++hint;
+        }
+    }
+    catch (...)
+    {
+        for (VertexNode v : added)
+        {
+            vmap.erase(v);
+        }
+
+        throw;
+    }
 }
 
-template <typename VertexInfo, typename EdgeInfo>
-void Digraph<VertexInfo, EdgeInfo>::addEdge(int fromVertex, int toVertex, const EdgeInfo& einfo)
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::addEdges(const std::vector<DigraphEdge<EdgeInfo>>& batch)
 {
-    checkVertexExistence(fromVertex);
-    checkVertexExistence(toVertex);
-    for (auto const& i : vmap[fromVertex].edges)
+    int n = static_cast<int>(batch.size());
+
+    // Sort the batch by "from" vertex, keeping the edges from each one
+    // in the order they were given, so that they end up in its edge
+    // list in that order, just as they would one addEdge() at a time.
+    std::vector<int> order(n);
+
+    for (int i = 0; i < n; ++i)
+    {
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return batch[a].fromVertex < batch[b].fromVertex;
+    });
+
+    // Look up each vertex once, and find the earliest edge in the batch
+    // that addEdge() would have refused.  An edge that appears in the
+    // batch more than once is refused everywhere after its first
+    // appearance.
+    std::vector<VertexNode> froms(n);
+    std::vector<VertexNode> tos(n);
+    std::vector<std::pair<int, int>> group;
+    int firstBad = n;
+
+    for (int first = 0, last = 0; first < n; first = last)
+    {
+        int fromVertex = batch[order[first]].fromVertex;
+        VertexNode from = vmap.find(fromVertex);
+        group.clear();
+
+        for (last = first; last < n && batch[order[last]].fromVertex == fromVertex; ++last)
+        {
+            int i = order[last];
+            froms[i] = from;
+            tos[i] = vmap.find(batch[i].toVertex);
+
+            if (from == vmap.end() || tos[i] == vmap.end()
+                || eindex.find(fromVertex, batch[i].toVertex) != nullptr)
+            {
+                firstBad = std::min(firstBad, i);
+            }
+
+            group.emplace_back(batch[i].toVertex, i);
+        }
+
+        std::sort(group.begin(), group.end());
+
+        for (std::size_t k = 1; k < group.size(); ++k)
+        {
+            if (group[k].first == group[k - 1].first)
+            {
+                firstBad = std::min(firstBad, group[k].second);
+            }
+        }
+    }
+
+    if (firstBad < n)
+    {
+        checkVertexExistence(batch[firstBad].fromVertex);
+        checkVertexExistence(batch[firstBad].toVertex);
+        throw DigraphException("Edge already exists");
+    }
+
+    eindex.reserve(eindex.size() + n);
+    int applied = 0;
+
+    try
+    {
+        for (; applied < n; ++applied)
+        {
+            int i = order[applied];
+            linkEdge(froms[i], tos[i], batch[i].einfo);
+        }
+    }
+    catch (...)
     {
-        if (i.fromVertex == fromVertex && i.toVertex == toVertex)
+        while (applied > 0)
         {
-            throw DigraphException("Edge already exists");
+            int i = order[--applied];
+            unlinkEdge(froms[i], tos[i], eindex.find(batch[i].fromVertex, batch[i].toVertex));
         }
+
+        throw;
     }
-    vmap[fromVertex].edges.push_back(DigraphEdge<EdgeInfo>{fromVertex, toVertex, einfo});
 }
 
-template <typename VertexInfo, typename EdgeInfo>
-void Digraph<VertexInfo, EdgeInfo>::removeVertex(int vertex)
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::removeEdges(const std::vector<std::pair<int, int>>& batch)
+{
+    int n = static_cast<int>(batch.size());
+
+    // Sorting by edge groups the batch by "from" vertex and puts
+    // repeats next to each other; only the first of them in the batch
+    // would succeed.
+    std::vector<int> order(n);
+
+    for (int i = 0; i < n; ++i)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return batch[a] != batch[b] ? batch[a] < batch[b] : a < b;
+    });
+
+    int firstBad = n;
+
+    for (int k = 0; k < n; ++k)
+    {
+        int i = order[k];
+        bool repeated = k > 0 && batch[order[k - 1]] == batch[i];
+
+        if (i < firstBad && (repeated || eindex.find(batch[i].first, batch[i].second) == nullptr))
+        {
+            firstBad = i;
+        }
+    }
+
+    if (firstBad < n)
+    {
+        checkVertexExistence(batch[firstBad].first);
+        checkVertexExistence(batch[firstBad].second);
+        throw DigraphException("Edge does not exist");
+    }
+
+    // Nothing below allocates, so nothing below can throw.
+    VertexNode from = vmap.end();
+
+    for (int i : order)
+    {
+        if (from == vmap.end() || from->first != batch[i].first)
+        {
+            from = vmap.find(batch[i].first);
+        }
+
+        unlinkEdge(from, vmap.find(batch[i].second), eindex.find(batch[i].first, batch[i].second));
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int Digraph<VertexInfo, EdgeInfo, Allocator>::vertexCount() const noexcept
+{
+    return vmap.size();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int Digraph<VertexInfo, EdgeInfo, Allocator>::edgeCount() const noexcept
+{
+    return edge_count;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int Digraph<VertexInfo, EdgeInfo, Allocator>::edgeCount(int vertex) const
 {
     checkVertexExistence(vertex);
-    vmap.erase(vertex);
+    return vmap.find(vertex)->second.edges.size();
+}
+
 
-    for (auto &i : vmap)
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int Digraph<VertexInfo, EdgeInfo, Allocator>::inDegree(int vertex) const
+{
+    checkVertexExistence(vertex);
+    return vmap.find(vertex)->second.incoming.size();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::vector<std::pair<int, int>> Digraph<VertexInfo, EdgeInfo, Allocator>::inEdges(int vertex) const
+{
+    checkVertexExistence(vertex);
+    std::vector<std::pair<int, int>> e_list;
+    for (int from : vmap.find(vertex)->second.incoming)
     {
-        i.second.edges.remove_if([&vertex](DigraphEdge<EdgeInfo> ed){return ed.fromVertex == vertex || ed.toVertex == vertex;});
+        e_list.push_back(std::pair<int, int>{from, vertex});
     }
+    return e_list;
 }
 
-template <typename VertexInfo, typename EdgeInfo>
-void Digraph<VertexInfo, EdgeInfo>::removeEdge(int fromVertex, int toVertex)
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+bool Digraph<VertexInfo, EdgeInfo, Allocator>::isStronglyConnected() const
 {
-    checkVertexExistence(fromVertex);
-    checkVertexExistence(toVertex);
+    DigraphCsr csr;
+    buildCsr(csr);
+    return csrIsStronglyConnected(csr);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphComponents Digraph<VertexInfo, EdgeInfo, Allocator>::stronglyConnectedComponents() const
+{
+    DigraphCsr csr;
+    buildCsr(csr);
+    return csrComponents(csr);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphBfsTree Digraph<VertexInfo, EdgeInfo, Allocator>::breadthFirstSearch(int startVertex, unsigned threads) const
+{
+    checkVertexExistence(startVertex);
+
+    DigraphCsr csr;
+    buildCsr(csr);
+    return csrBfsTree(csr, csr.indexOf(startVertex), threads);
+}
+
 
-    int original_size = edges().size();
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+template <typename PreVisit, typename PostVisit>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::depthFirstSearch(
+    int startVertex, PreVisit&& preVisit, PostVisit&& postVisit) const
+{
+    checkVertexExistence(startVertex);
+
+    DigraphCsr csr;
+    buildCsr(csr);
+
+    std::vector<bool> visited(csr.vertexCount());
+    std::vector<std::pair<int, int>> stack;
+
+    csrDepthFirstSearch(
+        csr, csr.indexOf(startVertex), visited, stack,
+        [&](int i) { preVisit(csr.numbers[i]); },
+        [&](int i) { postVisit(csr.numbers[i]); });
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+template <typename PreVisit, typename PostVisit>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::depthFirstTraversal(
+    PreVisit&& preVisit, PostVisit&& postVisit) const
+{
+    DigraphCsr csr;
+    buildCsr(csr);
 
-    for (auto &i : vmap)
+    std::vector<bool> visited(csr.vertexCount());
+    std::vector<std::pair<int, int>> stack;
+
+    for (int i = 0; i < csr.vertexCount(); ++i)
     {
-        i.second.edges.remove_if([&fromVertex, &toVertex](DigraphEdge<EdgeInfo> ed){return ed.fromVertex == fromVertex && ed.toVertex == toVertex;});
+        csrDepthFirstSearch(
+            csr, i, visited, stack,
+            [&](int j) { preVisit(csr.numbers[j]); },
+            [&](int j) { postVisit(csr.numbers[j]); });
     }
-    if (original_size == edges().size())
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::map<int, int> Digraph<VertexInfo, EdgeInfo, Allocator>::findShortestPaths(
+    int startVertex,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc) const
+{
+    std::map<int, double> distances;
+    return shortestPaths(startVertex, edgeWeightFunc, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::map<int, int> Digraph<VertexInfo, EdgeInfo, Allocator>::findShortestPaths(
+    int startVertex,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc,
+    std::map<int, double>& distances) const
+{
+    return shortestPaths(startVertex, edgeWeightFunc, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+template <typename WeightFn>
+std::map<int, int> Digraph<VertexInfo, EdgeInfo, Allocator>::findShortestPaths(
+    int startVertex, WeightFn&& edgeWeightFunc) const
+{
+    std::map<int, double> distances;
+    return shortestPaths(startVertex, edgeWeightFunc, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+template <typename WeightFn>
+std::map<int, int> Digraph<VertexInfo, EdgeInfo, Allocator>::findShortestPaths(
+    int startVertex, WeightFn&& edgeWeightFunc,
+    std::map<int, double>& distances) const
+{
+    return shortestPaths(startVertex, edgeWeightFunc, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+template <typename WeightFn>
+std::map<int, int> Digraph<VertexInfo, EdgeInfo, Allocator>::shortestPaths(
+    int startVertex, const WeightFn& edgeWeightFunc,
+    std::map<int, double>& distances) const
+{
+    checkVertexExistence(startVertex);
+
+    DigraphCsr csr;
+    std::vector<const EdgeInfo*> einfos;
+    buildCsr(csr, &einfos);
+
+    std::vector<double> distance;
+    std::vector<int> predecessor;
+    IndexedHeap<double> heap;
+
+    csrShortestPaths(
+        csr, csr.indexOf(startVertex),
+        [&](int e) { return edgeWeightFunc(*einfos[e]); },
+        distance, predecessor, heap);
+
+    distances = csrToMap(csr, distance);
+    return csrIndexMap(csr, predecessor);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphPathMatrix Digraph<VertexInfo, EdgeInfo, Allocator>::findShortestPathsMany(
+    const std::vector<int>& startVertices,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc,
+    unsigned threads) const
+{
+    for (int startVertex : startVertices)
     {
-        throw DigraphException("Edge does not exist");
+        checkVertexExistence(startVertex);
+    }
+
+    DigraphCsr csr;
+    std::vector<const EdgeInfo*> einfos;
+    buildCsr(csr, &einfos);
+
+    std::vector<int> sources;
+    sources.reserve(startVertices.size());
+
+    for (int startVertex : startVertices)
+    {
+        sources.push_back(csr.indexOf(startVertex));
+    }
+
+    std::vector<double> weights;
+    weights.reserve(einfos.size());
+
+    for (const EdgeInfo* einfo : einfos)
+    {
+        weights.push_back(edgeWeightFunc(*einfo));
     }
+
+    DigraphPathMatrix paths;
+    csrShortestPathsMany(csr, sources, weights, paths, threads);
+    return paths;
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-int Digraph<VertexInfo, EdgeInfo>::vertexCount() const noexcept
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::map<int, int> Digraph<VertexInfo, EdgeInfo, Allocator>::findShortestPathsParallel(
+    int startVertex,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc,
+    double delta, unsigned threads) const
 {
-    return vertices().size();
+    std::map<int, double> distances;
+    return findShortestPathsParallel(startVertex, edgeWeightFunc, distances, delta, threads);
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-int Digraph<VertexInfo, EdgeInfo>::edgeCount() const noexcept
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::map<int, int> Digraph<VertexInfo, EdgeInfo, Allocator>::findShortestPathsParallel(
+    int startVertex,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc,
+    std::map<int, double>& distances,
+    double delta, unsigned threads) const
 {
-    return edges().size();
+    checkVertexExistence(startVertex);
+
+    DigraphCsr csr;
+    std::vector<const EdgeInfo*> einfos;
+    buildCsr(csr, &einfos);
+
+    std::vector<double> weights;
+    weights.reserve(einfos.size());
+
+    for (const EdgeInfo* einfo : einfos)
+    {
+        weights.push_back(edgeWeightFunc(*einfo));
+    }
+
+    std::vector<double> distance;
+    std::vector<int> predecessor;
+    csrDeltaStepping(csr, csr.indexOf(startVertex), weights, delta, distance, predecessor, threads);
+
+    distances = csrToMap(csr, distance);
+    return csrIndexMap(csr, predecessor);
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-int Digraph<VertexInfo, EdgeInfo>::edgeCount(int vertex) const
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+template <typename WeightFn>
+DigraphRoute Digraph<VertexInfo, EdgeInfo, Allocator>::shortestPath(
+    int fromVertex, int toVertex, WeightFn&& edgeWeightFunc) const
 {
-    return edges(vertex).size();
+    checkVertexExistence(fromVertex);
+    checkVertexExistence(toVertex);
+
+    auto outEdges = [&](int u, DigraphRouteEdges& edges)
+    {
+        DIGRAPH_STATS_ADD(mapProbes, 1);
+
+        for (const DigraphEdge<EdgeInfo>& e : vmap.find(u)->second.edges)
+        {
+            edges.emplace_back(e.toVertex, edgeWeightFunc(e.einfo));
+        }
+    };
+
+    // The incoming vectors only hold vertex numbers, so each edge's info
+    // is looked up in eindex.
+    auto inEdges = [&](int v, DigraphRouteEdges& edges)
+    {
+        DIGRAPH_STATS_ADD(mapProbes, 1);
+
+        for (int u : vmap.find(v)->second.incoming)
+        {
+            edges.emplace_back(u, edgeWeightFunc(eindex.find(u, v)->edge->einfo));
+        }
+    };
+
+    return routeBidirectional(fromVertex, toVertex, outEdges, inEdges);
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-bool Digraph<VertexInfo, EdgeInfo>::isStronglyConnected() const
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+template <typename WeightFn, typename HeuristicFn>
+DigraphRoute Digraph<VertexInfo, EdgeInfo, Allocator>::shortestPath(
+    int fromVertex, int toVertex, WeightFn&& edgeWeightFunc,
+    HeuristicFn&& heuristicFunc) const
 {
-    for (const auto &v : vmap)
+    checkVertexExistence(fromVertex);
+    checkVertexExistence(toVertex);
+
+    const VertexInfo& targetInfo = vmap.find(toVertex)->second.vinfo;
+
+    auto outEdges = [&](int u, DigraphRouteEdges& edges)
     {
-        std::vector<int> vertex_list;
+        DIGRAPH_STATS_ADD(mapProbes, 1);
 
-        dft(vertex_list, v);
-        if (vertex_list.size() != vertices().size())
+        for (const DigraphEdge<EdgeInfo>& e : vmap.find(u)->second.edges)
         {
-            return false;
+            edges.emplace_back(e.toVertex, edgeWeightFunc(e.einfo));
         }
+    };
+
+    auto estimate = [&](int v)
+    {
+        DIGRAPH_STATS_ADD(mapProbes, 1);
+        return heuristicFunc(vmap.find(v)->second.vinfo, targetInfo);
+    };
+
+    return routeAStar(fromVertex, toVertex, outEdges, estimate);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::save(const std::string& path) const
+{
+    DigraphCsr csr;
+    std::vector<const EdgeInfo*> einfos;
+    buildCsr(csr, &einfos);
+
+    std::vector<const VertexInfo*> vinfos;
+    vinfos.reserve(vmap.size());
+
+    for (auto const& v : vmap)
+    {
+        vinfos.push_back(&v.second.vinfo);
+    }
+
+    bool written = writeDigraphFile<VertexInfo, EdgeInfo>(
+        path, csr,
+        [&](int i) -> const VertexInfo& { return *vinfos[i]; },
+        [&](int e) -> const EdgeInfo& { return *einfos[e]; });
+
+    if (!written)
+    {
+        throw DigraphException("Could not write " + path);
     }
-    return true;
 }
 
-template <typename VertexInfo, typename EdgeInfo>
-void Digraph<VertexInfo, EdgeInfo>::dft(std::vector<int>& vertex_list, const std::pair<int, DigraphVertex<VertexInfo, EdgeInfo>>& vertex) const
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+Digraph<VertexInfo, EdgeInfo, Allocator> Digraph<VertexInfo, EdgeInfo, Allocator>::load(
+    const std::string& path, const Allocator& alloc)
 {
-    vertex_list.push_back(vertex.first);
+    MappedFile file;
+
+    if (!file.open(path))
+    {
+        throw DigraphException("Could not read " + path);
+    }
+
+    DigraphCsrView csr;
+    const VertexInfo* vinfos;
+    const EdgeInfo* einfos;
+    const char* problem = readDigraphFile(file, csr, vinfos, einfos);
+
+    if (problem != nullptr)
+    {
+        throw DigraphException(path + ": " + problem);
+    }
+
+    Digraph d{alloc};
+    d.eindex.reserve(csr.edgeCount());
+
+    for (int u = 0; u < csr.vertexCount(); ++u)
+    {
+        d.addVertex(csr.numbers[u], vinfos[u]);
+    }
 
-    for (const auto &e : vertex.second.edges)
+    for (int u = 0; u < csr.vertexCount(); ++u)
     {
-        if (std::find(vertex_list.begin(), vertex_list.end(), e.toVertex) == vertex_list.end())
+        for (int e = csr.offsets[u]; e < csr.offsets[u + 1]; ++e)
         {
-            dft(vertex_list, *vmap.find(e.toVertex));
+            d.addEdge(csr.numbers[u], csr.numbers[csr.targets[e]], einfos[e]);
         }
     }
+
+    return d;
 }
 
-template <typename VertexInfo, typename EdgeInfo>
-std::map<int, int> Digraph<VertexInfo, EdgeInfo>::findShortestPaths(
-    int startVertex,
-    std::function<double(const EdgeInfo&)> edgeWeightFunc) const
-{
 
-    std::vector<int> vertex_list;
-    std::map<int, int> vertex_d;
-    std::map<int, int> vertex_p;
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::rebuildEdgeIndex()
+{
+    eindex.clear();
+    eindex.reserve(edge_count);
 
     for (auto &v : vmap)
     {
-        if (v.first == startVertex)
+        for (auto e = v.second.edges.begin(); e != v.second.edges.end(); ++e)
         {
-            vertex_d[v.first] = 0;
-            vertex_p[v.first] = v.first;
+            eindex.insert(e->fromVertex, e->toVertex, EdgeSlot{e, -1});
         }
-        else
+    }
+
+    for (auto &v : vmap)
+    {
+        for (int i = 0; i < static_cast<int>(v.second.incoming.size()); ++i)
         {
-            vertex_d[v.first] = INT_MAX;
+            eindex.find(v.second.incoming[i], v.first)->incomingSlot = i;
         }
     }
+}
 
-    std::priority_queue<int> pq;
-    pq.push(startVertex);
 
-    while (!pq.empty())
-    {
-        int min_priority_vertex = pq.top();
-        pq.pop();
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DigraphVertex<VertexInfo, EdgeInfo, Allocator> Digraph<VertexInfo, EdgeInfo, Allocator>::newVertex(const VertexInfo& vinfo) const
+{
+    typedef DigraphVertex<VertexInfo, EdgeInfo, Allocator> Vertex;
+    auto alloc = vmap.get_allocator();
 
-        if (std::find(vertex_list.begin(), vertex_list.end(), min_priority_vertex) == vertex_list.end())
-        {
-            vertex_list.push_back(min_priority_vertex);
+    return Vertex{
+        vinfo,
+        typename Vertex::EdgeList(typename Vertex::EdgeAllocator(alloc)),
+        typename Vertex::IncomingList(typename Vertex::IncomingAllocator(alloc))};
+}
 
-            for (auto &v : vmap.find(min_priority_vertex)->second.edges)
-            {
-                if (vertex_d[v.toVertex] > vertex_d[v.fromVertex] + edgeWeightFunc(v.einfo))
-                {
-                    vertex_d[v.toVertex] = vertex_d[v.fromVertex] + edgeWeightFunc(v.einfo);
-                    vertex_p[v.toVertex] = min_priority_vertex;
-                    pq.push(v.toVertex);
-                }
-            }
-        }
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::linkEdge(VertexNode from, VertexNode to, const EdgeInfo& einfo)
+{
+    auto& edges = from->second.edges;
+    auto& incoming = to->second.incoming;
+
+    // Once the index has room, inserting into it can't throw, so only
+    // the two containers below can fail partway through.
+    eindex.reserve(eindex.size() + 1);
+    incoming.push_back(from->first);
+
+    try
+    {
+        edges.push_back(DigraphEdge<EdgeInfo>{from->first, to->first, einfo});
+    }
+    catch (...)
+    {
+        incoming.pop_back();
+        throw;
     }
 
-    return vertex_p;
+    eindex.insert(from->first, to->first, EdgeSlot{std::prev(edges.end()), static_cast<int>(incoming.size()) - 1});
+    ++edge_count;
 }
 
 
-template <typename VertexInfo, typename EdgeInfo>
-void Digraph<VertexInfo, EdgeInfo>::checkVertexExistence(int vertex) const
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::unlinkEdge(VertexNode from, VertexNode to, EdgeSlot* edge)
 {
+    from->second.edges.erase(edge->edge);
+    unlinkIncoming(to->second, to->first, edge->incomingSlot);
+    eindex.erase(from->first, to->first);
+    --edge_count;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::unlinkIncoming(DigraphVertex<VertexInfo, EdgeInfo, Allocator>& to, int toVertex, int slot)
+{
+    // The last incoming edge moves into the vacated slot, so its entry
+    // in the index has to follow it.
+    int last = to.incoming.back();
+    to.incoming[slot] = last;
+    eindex.find(last, toVertex)->incomingSlot = slot;
+    to.incoming.pop_back();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::checkVertexExistence(int vertex) const
+{
+    DIGRAPH_STATS_ADD(mapProbes, 1);
+
     if (vmap.find(vertex) == vmap.end())
     {
         throw DigraphException("Vertex " + std::to_string(vertex) + " does not exist");
     }
 }
 
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void Digraph<VertexInfo, EdgeInfo, Allocator>::buildCsr(DigraphCsr& csr, std::vector<const EdgeInfo*>* einfos) const
+{
+    DIGRAPH_STATS_PHASE(buildSeconds);
+    DIGRAPH_STATS_ADD(allocations, csr.numbers.capacity() < vmap.size());
+    DIGRAPH_STATS_ADD(allocations, csr.offsets.capacity() < vmap.size() + 1);
+    DIGRAPH_STATS_ADD(allocations, csr.targets.capacity() < static_cast<std::size_t>(edge_count));
+
+    csr.numbers.clear();
+    csr.offsets.clear();
+    csr.targets.clear();
+
+    csr.numbers.reserve(vmap.size());
+    csr.offsets.reserve(vmap.size() + 1);
+    csr.targets.reserve(edge_count);
+
+    if (einfos != nullptr)
+    {
+        DIGRAPH_STATS_ADD(allocations, einfos->capacity() < static_cast<std::size_t>(edge_count));
+        einfos->clear();
+        einfos->reserve(edge_count);
+    }
+
+    for (auto const& v : vmap)
+    {
+        csr.numbers.push_back(v.first);
+    }
+
+    // Each edge's target is found through a DigraphNumberIndex, in
+    // constant time, rather than by searching csr.numbers.
+    DigraphNumberIndex index;
+    index.assign(csr.numbers);
+    csr.offsets.push_back(0);
+
+    for (auto const& v : vmap)
+    {
+        for (auto const& e : v.second.edges)
+        {
+            csr.targets.push_back(index.indexOf(e.toVertex));
+
+            if (einfos != nullptr)
+            {
+                einfos->push_back(&e.einfo);
+            }
+        }
+
+        csr.offsets.push_back(static_cast<int>(csr.targets.size()));
+    }
+}
+
     
 #endif // DIGRAPH_HPP
 
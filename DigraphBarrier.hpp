@@ -0,0 +1,93 @@
+// DigraphBarrier.hpp
+//
+// This header file declares a class called DigraphBarrier, which lets
+// a fixed team of threads wait for one another.  Parallel algorithms
+// that work level by level (like the breadth-first search in
+// DigraphBfs.hpp) start their threads once and use a barrier to keep
+// them in step, rather than starting new threads for every level.
+
+#ifndef DIGRAPHBARRIER_HPP
+#define DIGRAPHBARRIER_HPP
+
+#include <condition_variable>
+#include <mutex>
+
+
+
+class DigraphBarrier
+{
+public:
+    // The constructor initializes a barrier for the given number of
+    // threads.
+    explicit DigraphBarrier(unsigned threads);
+
+    DigraphBarrier(const DigraphBarrier&) = delete;
+    DigraphBarrier& operator=(const DigraphBarrier&) = delete;
+
+    // wait() blocks until every thread in the team has called it, then
+    // lets them all go.  The barrier can be used again right away.
+    // Everything a thread did before wait() is visible to every thread
+    // after it.
+    void wait();
+
+    // resize() changes the number of threads in the team, for when some
+    // of them couldn't be started.  If the threads already waiting make
+    // up the new number, they're let go.
+    void resize(unsigned threads);
+
+
+private:
+    std::mutex lock;
+    std::condition_variable released;
+    unsigned threads;
+    unsigned waiting;
+    unsigned long generation;
+};
+
+
+
+inline DigraphBarrier::DigraphBarrier(unsigned threads)
+    : threads{threads}, waiting{0}, generation{0}
+{
+}
+
+
+inline void DigraphBarrier::wait()
+{
+    std::unique_lock<std::mutex> guard{lock};
+
+    if (threads <= 1)
+    {
+        return;
+    }
+
+    unsigned long arrivedIn = generation;
+
+    if (++waiting == threads)
+    {
+        waiting = 0;
+        ++generation;
+        released.notify_all();
+        return;
+    }
+
+    released.wait(guard, [&] { return generation != arrivedIn; });
+}
+
+
+inline void DigraphBarrier::resize(unsigned threads)
+{
+    std::lock_guard<std::mutex> guard{lock};
+    this->threads = threads;
+
+    if (waiting != 0 && waiting >= threads)
+    {
+        waiting = 0;
+        ++generation;
+        released.notify_all();
+    }
+}
+
+
+
+#endif // DIGRAPHBARRIER_HPP
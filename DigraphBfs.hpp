@@ -0,0 +1,447 @@
+// DigraphBfs.hpp
+//
+// This header file declares csrBreadthFirstSearch(), a parallel
+// breadth-first search over a DigraphCsr, and DigraphBfsTree, the
+// result that Digraph, FrozenDigraph and MyGraphType return from
+// their breadth-first searches.
+//
+// The search is level-synchronous: every vertex at distance d from the
+// source is found before any vertex at distance d + 1, with all of the
+// threads working on the same level at once.  Each level is searched
+// in one of two directions (Beamer, Asanovic and Patterson,
+// "Direction-Optimizing Breadth-First Search"):
+//
+// * top-down, where the threads share out the frontier (the vertices
+//   found on the previous level) and claim each unvisited vertex it
+//   has an edge to, by atomically setting its bit in a visited bitmap
+// * bottom-up, where the threads share out the unvisited vertices and
+//   each one looks through its incoming edges for a parent that is in
+//   the frontier, stopping at the first one it finds
+//
+// Top-down is cheaper while the frontier is small, but once it holds
+// a sizeable share of the graph most of the edges it checks lead to
+// vertices that are already visited, and bottom-up, which can stop
+// early, checks far fewer.  The search switches to bottom-up when the
+// frontier's outgoing edges outnumber a fraction of the incoming edges
+// of the unvisited vertices, and back to top-down once the frontier is
+// shrinking and small again.
+
+#ifndef DIGRAPHBFS_HPP
+#define DIGRAPHBFS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "DigraphBarrier.hpp"
+#include "DigraphCsr.hpp"
+
+
+
+// A DigraphBfsTree describes the outcome of a breadth-first search.
+// All three vectors are parallel, with one element per vertex in
+// ascending order of vertex number.
+//
+// * vertices lists the vertex numbers
+// * level is the number of edges on a shortest path from the start
+//   vertex to each vertex, or -1 for vertices that weren't reached
+// * parent is the vertex number of each vertex's predecessor on such
+//   a path; like findShortestPaths(), the start vertex and vertices
+//   that weren't reached are their own parents
+
+struct DigraphBfsTree
+{
+    std::vector<int> vertices;
+    std::vector<int> level;
+    std::vector<int> parent;
+};
+
+
+
+// Graphs with fewer vertices than this are always searched on a single
+// thread, since starting the others would take longer than the search.
+const int csrParallelBfsThreshold = 1 << 14;
+
+
+
+// csrBreadthFirstSearch() searches csr breadth-first from the given
+// source index, using the given number of threads (or, if it's zero,
+// one per hardware thread).  reverse must be the transpose of csr (see
+// csrTranspose()).  When it returns, level[i] is the level of vertex i
+// or -1, and parent[i] is the index of its parent: the source's parent
+// is itself and unreached vertices' parents are -1.  If a thread can't
+// be started, the search goes on without it.
+
+inline void csrBreadthFirstSearch(
+    const DigraphCsrView& csr, const DigraphCsrView& reverse, int source,
+    std::vector<int>& level, std::vector<int>& parent, unsigned threads = 0)
+{
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    // These are the tuning parameters suggested in Beamer's paper.
+    const long long alpha = 14;
+    const long long beta = 24;
+
+    // Top-down levels share out the frontier this many vertices at a
+    // time, and bottom-up levels share out the visited bitmap this many
+    // words at a time, so that no two threads ever write the same word
+    // of the next frontier's bitmap.
+    const std::size_t frontierChunk = 64;
+    const std::size_t wordChunk = 16;
+
+    int n = csr.vertexCount();
+
+    level.assign(n, -1);
+    parent.assign(n, -1);
+
+    if (source < 0 || source >= n)
+    {
+        return;
+    }
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    if (n < csrParallelBfsThreshold)
+    {
+        threads = 1;
+    }
+
+    std::size_t words = (static_cast<std::size_t>(n) + 63) / 64;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> visited{new std::atomic<std::uint64_t>[words]};
+
+    for (std::size_t w = 0; w < words; ++w)
+    {
+        visited[w].store(0, std::memory_order_relaxed);
+    }
+
+    std::vector<std::uint64_t> frontierBits(words);
+    std::vector<std::uint64_t> nextBits(words);
+    std::vector<int> frontier;
+
+    // Each thread collects what it finds in its own Worker, which is
+    // padded so that two threads' counters never share a cache line.
+    struct Worker
+    {
+        std::vector<int> found;
+        long long outEdges;
+        long long inEdges;
+        int count;
+        char padding[64];
+    };
+
+    std::vector<Worker> workers(threads);
+
+    auto outDegree = [&](int v) { return csr.offsets[v + 1] - csr.offsets[v]; };
+    auto inDegree = [&](int v) { return reverse.offsets[v + 1] - reverse.offsets[v]; };
+
+    visited[source / 64].store(std::uint64_t{1} << (source % 64), std::memory_order_relaxed);
+    level[source] = 0;
+    parent[source] = source;
+    frontier.push_back(source);
+    DIGRAPH_STATS_ADD(verticesSettled, 1);
+
+    // This state is only changed by thread 0, between levels.
+    bool bottomUp = false;
+    bool done = false;
+    int depth = 0;
+    long long frontierCount = 1;
+    long long uncheckedEdges = static_cast<long long>(csr.edgeCount()) - inDegree(source);
+    std::atomic<std::size_t> nextChunk{0};
+
+    auto searchTopDown = [&](Worker& worker)
+    {
+        for (;;)
+        {
+            std::size_t first = nextChunk.fetch_add(frontierChunk, std::memory_order_relaxed);
+
+            if (first >= frontier.size())
+            {
+                return;
+            }
+
+            std::size_t last = std::min(first + frontierChunk, frontier.size());
+
+            for (std::size_t i = first; i < last; ++i)
+            {
+                int u = frontier[i];
+
+                DIGRAPH_STATS_ADD(edgesRelaxed, csr.offsets[u + 1] - csr.offsets[u]);
+
+                for (int e = csr.offsets[u]; e < csr.offsets[u + 1]; ++e)
+                {
+                    int v = csr.targets[e];
+                    std::uint64_t bit = std::uint64_t{1} << (v % 64);
+                    std::atomic<std::uint64_t>& word = visited[v / 64];
+
+                    // Checking before claiming keeps the common case (a
+                    // vertex that's already visited) free of atomic
+                    // read-modify-writes.
+                    if ((word.load(std::memory_order_relaxed) & bit) != 0
+                        || (word.fetch_or(bit, std::memory_order_relaxed) & bit) != 0)
+                    {
+                        continue;
+                    }
+
+                    level[v] = depth + 1;
+                    parent[v] = u;
+                    worker.found.push_back(v);
+                    DIGRAPH_STATS_ADD(verticesSettled, 1);
+                    worker.outEdges += outDegree(v);
+                    worker.inEdges += inDegree(v);
+                }
+            }
+        }
+    };
+
+    auto searchBottomUp = [&](Worker& worker)
+    {
+        for (;;)
+        {
+            std::size_t first = nextChunk.fetch_add(wordChunk, std::memory_order_relaxed);
+
+            if (first >= words)
+            {
+                return;
+            }
+
+            std::size_t last = std::min(first + wordChunk, words);
+
+            for (std::size_t w = first; w < last; ++w)
+            {
+                std::uint64_t unvisited = ~visited[w].load(std::memory_order_relaxed);
+                std::uint64_t found = 0;
+
+                for (int b = 0; unvisited != 0 && b < 64; ++b, unvisited >>= 1)
+                {
+                    int v = static_cast<int>(w * 64) + b;
+
+                    if ((unvisited & 1) == 0 || v >= n)
+                    {
+                        continue;
+                    }
+
+                    for (int e = reverse.offsets[v]; e < reverse.offsets[v + 1]; ++e)
+                    {
+                        int u = reverse.targets[e];
+                        DIGRAPH_STATS_ADD(edgesRelaxed, 1);
+
+                        if ((frontierBits[u / 64] >> (u % 64)) & 1)
+                        {
+                            level[v] = depth + 1;
+                            parent[v] = u;
+                            found |= std::uint64_t{1} << b;
+                            ++worker.count;
+                            DIGRAPH_STATS_ADD(verticesSettled, 1);
+                            worker.outEdges += outDegree(v);
+                            worker.inEdges += inDegree(v);
+                            break;
+                        }
+                    }
+                }
+
+                nextBits[w] = found;
+
+                if (found != 0)
+                {
+                    visited[w].fetch_or(found, std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+
+    auto searchLevel = [&](unsigned t)
+    {
+        Worker& worker = workers[t];
+
+        if (bottomUp)
+        {
+            searchBottomUp(worker);
+        }
+        else
+        {
+            searchTopDown(worker);
+        }
+    };
+
+    // finishLevel() gathers up what the threads found on the level
+    // that was just searched, and decides which direction to search
+    // the next one in.
+    auto finishLevel = [&]
+    {
+        long long nextCount = 0;
+        long long nextEdges = 0;
+
+        for (Worker& worker : workers)
+        {
+            nextCount += bottomUp ? worker.count : static_cast<long long>(worker.found.size());
+            nextEdges += worker.outEdges;
+            uncheckedEdges -= worker.inEdges;
+            worker.outEdges = 0;
+            worker.inEdges = 0;
+            worker.count = 0;
+        }
+
+        if (nextCount == 0)
+        {
+            done = true;
+            return;
+        }
+
+        bool nextBottomUp = bottomUp;
+
+        if (!bottomUp && nextEdges > uncheckedEdges / alpha)
+        {
+            nextBottomUp = true;
+        }
+        else if (bottomUp && nextCount < frontierCount && nextCount < n / beta)
+        {
+            nextBottomUp = false;
+        }
+
+        if (!bottomUp)
+        {
+            frontier.clear();
+
+            for (Worker& worker : workers)
+            {
+                frontier.insert(frontier.end(), worker.found.begin(), worker.found.end());
+                worker.found.clear();
+            }
+
+            if (nextBottomUp)
+            {
+                std::fill(frontierBits.begin(), frontierBits.end(), 0);
+
+                for (int v : frontier)
+                {
+                    frontierBits[v / 64] |= std::uint64_t{1} << (v % 64);
+                }
+            }
+        }
+        else
+        {
+            frontierBits.swap(nextBits);
+
+            if (!nextBottomUp)
+            {
+                frontier.clear();
+
+                for (std::size_t w = 0; w < words; ++w)
+                {
+                    std::uint64_t bits = frontierBits[w];
+
+                    for (int b = 0; bits != 0; ++b, bits >>= 1)
+                    {
+                        if ((bits & 1) != 0)
+                        {
+                            frontier.push_back(static_cast<int>(w * 64) + b);
+                        }
+                    }
+                }
+            }
+        }
+
+        bottomUp = nextBottomUp;
+        frontierCount = nextCount;
+        ++depth;
+    };
+
+    for (Worker& worker : workers)
+    {
+        worker.outEdges = 0;
+        worker.inEdges = 0;
+        worker.count = 0;
+    }
+
+    DigraphBarrier barrier{threads};
+    std::vector<std::thread> helpers;
+
+    // Each level takes two trips through the barrier: one after thread
+    // 0 has set it up, and one after every thread has searched it.
+    auto help = [&](unsigned t)
+    {
+        for (;;)
+        {
+            barrier.wait();
+
+            if (done)
+            {
+                return;
+            }
+
+            searchLevel(t);
+            barrier.wait();
+        }
+    };
+
+    // If a helper can't be started, the others carry on without it.
+    try
+    {
+        helpers.reserve(threads - 1);
+
+        for (unsigned t = 1; t < threads; ++t)
+        {
+            helpers.emplace_back(help, t);
+        }
+    }
+    catch (...)
+    {
+        barrier.resize(static_cast<unsigned>(helpers.size()) + 1);
+    }
+
+    for (;;)
+    {
+        nextChunk.store(0, std::memory_order_relaxed);
+        barrier.wait();
+
+        if (done)
+        {
+            break;
+        }
+
+        searchLevel(0);
+        barrier.wait();
+        finishLevel();
+    }
+
+    for (std::thread& helper : helpers)
+    {
+        helper.join();
+    }
+}
+
+
+// csrBfsTree() transposes csr, searches it breadth-first from the given
+// source index and returns the result in terms of vertex numbers.
+
+inline DigraphBfsTree csrBfsTree(const DigraphCsrView& csr, int source, unsigned threads = 0)
+{
+    DigraphCsr reverse;
+    std::vector<int> forwardEdge;
+    csrTranspose(csr, reverse, forwardEdge);
+
+    DigraphBfsTree tree;
+    std::vector<int> parent;
+    csrBreadthFirstSearch(csr, reverse, source, tree.level, parent, threads);
+
+    int n = csr.vertexCount();
+    tree.vertices.assign(csr.numbers, csr.numbers + n);
+    tree.parent.resize(n);
+
+    for (int i = 0; i < n; ++i)
+    {
+        tree.parent[i] = csr.numbers[parent[i] < 0 ? i : parent[i]];
+    }
+
+    return tree;
+}
+
+
+
+#endif // DIGRAPHBFS_HPP
@@ -0,0 +1,580 @@
+// DigraphCsr.hpp
+//
+// This header file declares DigraphCsr, a compressed sparse row (CSR)
+// picture of a directed graph's topology, along with the graph
+// algorithms that run on it.
+//
+// In a DigraphCsr, the vertices are renumbered densely as 0 through
+// n - 1 in ascending order of their vertex numbers, and the outgoing
+// edges of vertex i are the targets[offsets[i]] through
+// targets[offsets[i + 1] - 1].  Because everything lives in a few
+// contiguous arrays, the algorithms below can keep their per-vertex
+// state in plain std::vectors instead of std::maps.
+//
+// A DigraphCsr owns its arrays.  The algorithms run on a DigraphCsrView
+// instead, which only points at the three arrays, so that they can just
+// as well run on arrays that live somewhere else (like a memory-mapped
+// file; see DigraphFile.hpp).  A DigraphCsr converts to a view of itself
+// wherever one is needed.
+//
+// Digraph builds one of these whenever it runs an algorithm; the
+// algorithms themselves don't know anything about VertexInfo or
+// EdgeInfo, and get edge weights from a callable that is given an
+// edge's index in the targets array.
+
+#ifndef DIGRAPHCSR_HPP
+#define DIGRAPHCSR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "DigraphStats.hpp"
+#include "IndexedHeap.hpp"
+
+
+
+struct DigraphCsrView
+{
+    const int* numbers;
+    const int* offsets;
+    const int* targets;
+    int vertices;
+    int edges;
+
+    // vertexCount() and edgeCount() return the number of vertices and
+    // edges in the CSR.
+    int vertexCount() const noexcept;
+    int edgeCount() const noexcept;
+
+    // indexOf() returns the dense index of the given vertex number, or
+    // -1 if there is no such vertex.
+    int indexOf(int vertex) const noexcept;
+};
+
+
+struct DigraphCsr
+{
+    std::vector<int> numbers;
+    std::vector<int> offsets;
+    std::vector<int> targets;
+
+    int vertexCount() const noexcept;
+    int edgeCount() const noexcept;
+    int indexOf(int vertex) const noexcept;
+
+    // A DigraphCsr can be used anywhere a DigraphCsrView is expected.
+    // The view is only good until the DigraphCsr next changes.
+    operator DigraphCsrView() const noexcept;
+};
+
+
+
+// A DigraphNumberIndex finds the dense index of a vertex number in
+// constant time, for packing edges into a CSR without searching the
+// numbers for each edge's target.  When the vertex numbers are packed
+// closely (as they are in a graph numbered 0 through V - 1) it reads
+// the index from a table with a slot for every number in their range;
+// otherwise it keeps a hash table.
+
+class DigraphNumberIndex
+{
+public:
+    // The constructor initializes an index of no vertex numbers.
+    DigraphNumberIndex();
+
+    // assign() indexes the given vertex numbers, which must be distinct
+    // and in ascending order, as in DigraphCsr::numbers.
+    void assign(const std::vector<int>& numbers);
+
+    // indexOf() returns the dense index of the given vertex number, or
+    // -1 if it wasn't one of the numbers indexed.
+    int indexOf(int vertex) const noexcept;
+
+
+private:
+    long long lowest;
+    std::vector<int> table;
+    std::unordered_map<int, int> hashed;
+};
+
+
+
+// A DigraphComponents describes the strongly connected components of
+// a graph.  Components are numbered 0 through members.size() - 1 in
+// topological order, so every edge between two different components
+// points from a lower-numbered one to a higher-numbered one.
+//
+// * component maps each vertex number to the id of its component
+// * members lists the vertex numbers in each component
+// * successors is the condensation DAG: for each component, the ids
+//   of the other components its vertices have edges into, each listed
+//   once
+
+struct DigraphComponents
+{
+    std::map<int, int> component;
+    std::vector<std::vector<int>> members;
+    std::vector<std::vector<int>> successors;
+};
+
+
+
+inline int DigraphCsrView::vertexCount() const noexcept
+{
+    return vertices;
+}
+
+
+inline int DigraphCsrView::edgeCount() const noexcept
+{
+    return edges;
+}
+
+
+inline int DigraphCsrView::indexOf(int vertex) const noexcept
+{
+    const int* i = std::lower_bound(numbers, numbers + vertices, vertex);
+
+    if (i == numbers + vertices || *i != vertex)
+    {
+        return -1;
+    }
+
+    return static_cast<int>(i - numbers);
+}
+
+
+inline int DigraphCsr::vertexCount() const noexcept
+{
+    return static_cast<int>(numbers.size());
+}
+
+
+inline int DigraphCsr::edgeCount() const noexcept
+{
+    return static_cast<int>(targets.size());
+}
+
+
+inline int DigraphCsr::indexOf(int vertex) const noexcept
+{
+    return DigraphCsrView(*this).indexOf(vertex);
+}
+
+
+inline DigraphCsr::operator DigraphCsrView() const noexcept
+{
+    return DigraphCsrView{numbers.data(), offsets.data(), targets.data(), vertexCount(), edgeCount()};
+}
+
+
+inline DigraphNumberIndex::DigraphNumberIndex()
+    : lowest{0}
+{
+}
+
+
+inline void DigraphNumberIndex::assign(const std::vector<int>& numbers)
+{
+    table.clear();
+    hashed.clear();
+    lowest = numbers.empty() ? 0 : numbers.front();
+
+    long long span = numbers.empty() ? 0 : static_cast<long long>(numbers.back()) - lowest + 1;
+
+    if (span <= 4 * static_cast<long long>(numbers.size()))
+    {
+        table.assign(static_cast<std::size_t>(span), -1);
+
+        for (std::size_t i = 0; i < numbers.size(); ++i)
+        {
+            table[static_cast<std::size_t>(numbers[i] - lowest)] = static_cast<int>(i);
+        }
+    }
+    else
+    {
+        hashed.reserve(numbers.size());
+
+        for (std::size_t i = 0; i < numbers.size(); ++i)
+        {
+            hashed.emplace(numbers[i], static_cast<int>(i));
+        }
+    }
+}
+
+
+inline int DigraphNumberIndex::indexOf(int vertex) const noexcept
+{
+    if (hashed.empty())
+    {
+        long long slot = vertex - lowest;
+        return slot >= 0 && slot < static_cast<long long>(table.size()) ? table[static_cast<std::size_t>(slot)] : -1;
+    }
+
+    auto found = hashed.find(vertex);
+    return found != hashed.end() ? found->second : -1;
+}
+
+
+
+// csrShortestPaths() runs Dijkstra's Shortest Path Algorithm from the
+// vertex with the given dense index.  weightAt(e) must return the
+// (non-negative) weight of the edge with index e in csr.targets; it is
+// called exactly once for each edge leaving a reachable vertex.
+//
+// When it returns, distance[i] is the length of the shortest path to
+// vertex i (infinity if i is unreachable) and predecessor[i] is the
+// dense index of the vertex before i on that path (i itself for the
+// source and for unreachable vertices).  The heap is only used as
+// scratch space, so callers running many searches can reuse one.
+
+template <typename WeightAt>
+void csrShortestPaths(
+    const DigraphCsrView& csr, int source, WeightAt&& weightAt,
+    std::vector<double>& distance, std::vector<int>& predecessor,
+    IndexedHeap<double>& heap)
+{
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    int n = csr.vertexCount();
+
+    DIGRAPH_STATS_ADD(allocations, distance.capacity() < static_cast<std::size_t>(n));
+    DIGRAPH_STATS_ADD(allocations, predecessor.capacity() < static_cast<std::size_t>(n));
+
+    distance.assign(n, std::numeric_limits<double>::infinity());
+    predecessor.resize(n);
+
+    for (int i = 0; i < n; ++i)
+    {
+        predecessor[i] = i;
+    }
+
+    heap.reset(n);
+    distance[source] = 0.0;
+    heap.push(source, 0.0);
+
+    while (!heap.empty())
+    {
+        double d = heap.topPriority();
+        int u = heap.pop();
+
+        DIGRAPH_STATS_ADD(verticesSettled, 1);
+        DIGRAPH_STATS_ADD(edgesRelaxed, csr.offsets[u + 1] - csr.offsets[u]);
+
+        for (int e = csr.offsets[u]; e < csr.offsets[u + 1]; ++e)
+        {
+            int v = csr.targets[e];
+            double candidate = d + weightAt(e);
+
+            if (candidate < distance[v])
+            {
+                distance[v] = candidate;
+                predecessor[v] = u;
+                heap.pushOrDecrease(v, candidate);
+            }
+        }
+    }
+}
+
+
+// csrToMap() turns a per-vertex array of values into a std::map keyed
+// by vertex number.  When the values are themselves dense indices (as
+// predecessors are), csrIndexMap() translates them back into vertex
+// numbers as well.
+
+template <typename T>
+std::map<int, T> csrToMap(const DigraphCsrView& csr, const std::vector<T>& values)
+{
+    DIGRAPH_STATS_PHASE(resultSeconds);
+
+    std::map<int, T> result;
+
+    for (int i = 0; i < csr.vertexCount(); ++i)
+    {
+        result.emplace_hint(result.end(), csr.numbers[i], values[i]);
+    }
+
+    return result;
+}
+
+
+inline std::map<int, int> csrIndexMap(const DigraphCsrView& csr, const std::vector<int>& indices)
+{
+    DIGRAPH_STATS_PHASE(resultSeconds);
+
+    std::map<int, int> result;
+
+    for (int i = 0; i < csr.vertexCount(); ++i)
+    {
+        result.emplace_hint(result.end(), csr.numbers[i], csr.numbers[indices[i]]);
+    }
+
+    return result;
+}
+
+
+
+// csrTranspose() fills reverse with the transpose of csr (the same
+// vertices with every edge turned around).  forwardEdge[e] is set to
+// the index in csr.targets of the edge that reverse's edge e came from,
+// so that callers can still find that edge's information.
+
+inline void csrTranspose(const DigraphCsrView& csr, DigraphCsr& reverse, std::vector<int>& forwardEdge)
+{
+    DIGRAPH_STATS_PHASE(buildSeconds);
+
+    int n = csr.vertexCount();
+    int m = csr.edgeCount();
+
+    reverse.numbers.assign(csr.numbers, csr.numbers + n);
+    reverse.offsets.assign(n + 1, 0);
+    reverse.targets.resize(m);
+    forwardEdge.resize(m);
+
+    for (int e = 0; e < m; ++e)
+    {
+        ++reverse.offsets[csr.targets[e] + 1];
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        reverse.offsets[i + 1] += reverse.offsets[i];
+    }
+
+    std::vector<int> next(reverse.offsets.begin(), reverse.offsets.end() - 1);
+
+    for (int u = 0; u < n; ++u)
+    {
+        for (int e = csr.offsets[u]; e < csr.offsets[u + 1]; ++e)
+        {
+            int slot = next[csr.targets[e]]++;
+            reverse.targets[slot] = u;
+            forwardEdge[slot] = e;
+        }
+    }
+}
+
+
+// csrDepthFirstSearch() searches depth-first from the given start
+// index, skipping vertices already marked in visited (which must be
+// sized to the vertex count) and marking every vertex it reaches.  It
+// calls preVisit(i) when it first reaches vertex i and postVisit(i)
+// once everything reachable from i has been finished, in the same
+// order a recursive search would.  Instead of recursing, it keeps its
+// own stack of (vertex, next edge) pairs in stack, so that a caller
+// running many searches can reuse one buffer for all of them.
+
+template <typename PreVisit, typename PostVisit>
+void csrDepthFirstSearch(
+    const DigraphCsrView& csr, int start,
+    std::vector<bool>& visited, std::vector<std::pair<int, int>>& stack,
+    PreVisit&& preVisit, PostVisit&& postVisit)
+{
+    if (visited[start])
+    {
+        return;
+    }
+
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    visited[start] = true;
+    preVisit(start);
+    stack.clear();
+    stack.emplace_back(start, csr.offsets[start]);
+
+    while (!stack.empty())
+    {
+        std::pair<int, int>& top = stack.back();
+        int u = top.first;
+
+        if (top.second == csr.offsets[u + 1])
+        {
+            DIGRAPH_STATS_ADD(verticesSettled, 1);
+            stack.pop_back();
+            postVisit(u);
+            continue;
+        }
+
+        DIGRAPH_STATS_ADD(edgesRelaxed, 1);
+        int v = csr.targets[top.second++];
+
+        if (!visited[v])
+        {
+            visited[v] = true;
+            preVisit(v);
+            stack.emplace_back(v, csr.offsets[v]);
+        }
+    }
+}
+
+
+
+// csrStronglyConnectedComponents() runs an iterative version of
+// Tarjan's algorithm, storing in component[i] the id of the strongly
+// connected component of vertex i and returning the number of
+// components.  Ids are in topological order, as in DigraphComponents.
+// If stopEarly is true, the search gives up (and returns 0) as soon as
+// it finds a component that is not the whole graph, which is all that
+// csrIsStronglyConnected() needs to know.
+
+inline int csrStronglyConnectedComponents(
+    const DigraphCsrView& csr, std::vector<int>& component, bool stopEarly = false)
+{
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    int n = csr.vertexCount();
+
+    // order, low and nextEdge are allocated afresh every time.
+    DIGRAPH_STATS_ADD(allocations, n > 0 ? 3 : 0);
+    DIGRAPH_STATS_ADD(allocations, component.capacity() < static_cast<std::size_t>(n));
+
+    std::vector<int> order(n, -1);
+    std::vector<int> low(n, 0);
+    std::vector<int> nextEdge(n, 0);
+    std::vector<int> callStack;
+    std::vector<int> sccStack;
+    int counter = 0;
+    int found = 0;
+
+    component.assign(n, -1);
+
+    for (int root = 0; root < n; ++root)
+    {
+        if (order[root] >= 0)
+        {
+            continue;
+        }
+
+        order[root] = low[root] = counter++;
+        nextEdge[root] = csr.offsets[root];
+        callStack.push_back(root);
+        sccStack.push_back(root);
+
+        while (!callStack.empty())
+        {
+            int u = callStack.back();
+
+            if (nextEdge[u] < csr.offsets[u + 1])
+            {
+                DIGRAPH_STATS_ADD(edgesRelaxed, 1);
+                int v = csr.targets[nextEdge[u]++];
+
+                if (order[v] < 0)
+                {
+                    order[v] = low[v] = counter++;
+                    nextEdge[v] = csr.offsets[v];
+                    callStack.push_back(v);
+                    sccStack.push_back(v);
+                }
+                else if (component[v] < 0 && order[v] < low[u])
+                {
+                    low[u] = order[v];
+                }
+
+                continue;
+            }
+
+            callStack.pop_back();
+            DIGRAPH_STATS_ADD(verticesSettled, 1);
+
+            if (!callStack.empty() && low[u] < low[callStack.back()])
+            {
+                low[callStack.back()] = low[u];
+            }
+
+            if (low[u] == order[u])
+            {
+                if (stopEarly && (u != root || static_cast<int>(sccStack.size()) != n))
+                {
+                    return 0;
+                }
+
+                int w;
+
+                do
+                {
+                    w = sccStack.back();
+                    sccStack.pop_back();
+                    component[w] = found;
+                }
+                while (w != u);
+
+                ++found;
+            }
+        }
+    }
+
+    // Tarjan's algorithm finishes the components in reverse topological
+    // order, so flip the ids around.
+    for (int i = 0; i < n; ++i)
+    {
+        component[i] = found - 1 - component[i];
+    }
+
+    return found;
+}
+
+
+// csrIsStronglyConnected() returns true if every vertex of csr can
+// reach every other one.  It runs in O(V + E) time, and usually stops
+// well before that on graphs that aren't strongly connected.
+
+inline bool csrIsStronglyConnected(const DigraphCsrView& csr)
+{
+    std::vector<int> component;
+    return csr.vertexCount() == 0 || csrStronglyConnectedComponents(csr, component, true) == 1;
+}
+
+
+// csrComponents() finds the strongly connected components of csr and
+// describes them, and the condensation DAG, as a DigraphComponents.
+
+inline DigraphComponents csrComponents(const DigraphCsrView& csr)
+{
+    DigraphComponents result;
+    std::vector<int> component;
+    int count = csrStronglyConnectedComponents(csr, component);
+
+    result.component = csrToMap(csr, component);
+    result.members.resize(count);
+    result.successors.resize(count);
+
+    std::vector<std::vector<int>> memberIndices(count);
+
+    for (int i = 0; i < csr.vertexCount(); ++i)
+    {
+        result.members[component[i]].push_back(csr.numbers[i]);
+        memberIndices[component[i]].push_back(i);
+    }
+
+    // Walking the edges one component at a time means lastSeen[d] == c
+    // exactly when component c already lists d as a successor.
+    std::vector<int> lastSeen(count, -1);
+
+    for (int c = 0; c < count; ++c)
+    {
+        for (int u : memberIndices[c])
+        {
+            for (int e = csr.offsets[u]; e < csr.offsets[u + 1]; ++e)
+            {
+                int d = component[csr.targets[e]];
+
+                if (d != c && lastSeen[d] != c)
+                {
+                    lastSeen[d] = c;
+                    result.successors[c].push_back(d);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+
+
+#endif // DIGRAPHCSR_HPP
@@ -0,0 +1,474 @@
+// DigraphDeltaStepping.hpp
+//
+// This header file declares csrDeltaStepping(), a parallel single-source
+// shortest path search over a DigraphCsr, for graphs big enough that one
+// Dijkstra search on one thread takes too long.
+//
+// It uses Meyer and Sanders' delta-stepping ("Delta-stepping: a
+// parallelizable shortest path algorithm").  Rather than settling one
+// vertex at a time in order of distance, it sorts the vertices it has
+// found into buckets of width delta (bucket b holds the ones whose
+// tentative distance is at least b * delta and less than (b + 1) * delta)
+// and settles a whole bucket at once, with all of the threads working
+// on it together:
+//
+// * edges no heavier than delta are light, and relaxing one from a
+//   vertex in the current bucket can put its target into the same
+//   bucket, so the light edges of the bucket's vertices are relaxed
+//   over and over, in rounds, until no round puts anything new into it
+// * heavier edges can only lead to later buckets, so they are relaxed
+//   just once, from every vertex that was settled in the bucket, after
+//   the light rounds are over
+//
+// Each thread files the vertices it finds into buckets of its own, so
+// the only shared state the threads write is each vertex's distance and
+// predecessor.  Those are lowered together, under a tiny per-vertex
+// spin lock that's only taken when the new distance looks shorter than
+// the old one; vertices are never taken out of buckets when they get
+// shorter distances, they're just skipped when they come up in a bucket
+// that no longer matches their distance.
+//
+// A small delta does less work that turns out to be wasted, since the
+// buckets come out closer to Dijkstra's order, but leaves less work for
+// each round; a large one the other way around.  A width near the
+// heaviest edge weight divided by the average out-degree is a good
+// place to start, and is what's used if none is given.  The buckets are
+// kept in an array with one entry for every delta of distance, so delta
+// shouldn't be so small that the longest shortest path spans billions
+// of them.
+
+#ifndef DIGRAPHDELTASTEPPING_HPP
+#define DIGRAPHDELTASTEPPING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "DigraphBarrier.hpp"
+#include "DigraphCsr.hpp"
+
+
+
+// Graphs with fewer vertices than this are always searched on a single
+// thread, since starting the others would take longer than the search.
+const int csrParallelDeltaSteppingThreshold = 1 << 14;
+
+
+
+// csrDeltaSteppingWidth() returns the bucket width csrDeltaStepping()
+// uses when it isn't given one: the heaviest finite edge weight divided
+// by the average out-degree, or 1 if every edge weighs nothing.
+
+inline double csrDeltaSteppingWidth(const DigraphCsrView& csr, const std::vector<double>& weights)
+{
+    double heaviest = 0.0;
+
+    for (double weight : weights)
+    {
+        if (weight > heaviest && weight < std::numeric_limits<double>::infinity())
+        {
+            heaviest = weight;
+        }
+    }
+
+    if (heaviest == 0.0)
+    {
+        return 1.0;
+    }
+
+    double degree = static_cast<double>(csr.edgeCount()) / std::max(csr.vertexCount(), 1);
+    return heaviest / std::max(degree, 1.0);
+}
+
+
+// csrDeltaStepping() finds the shortest paths from the given source
+// index, with buckets of the given width (or, if it isn't positive, the
+// one csrDeltaSteppingWidth() picks), using the given number of threads
+// (or, if it's zero, one per hardware thread).  weights[e] must be the
+// non-negative weight of the edge with index e in csr.targets.
+//
+// When it returns, distance and predecessor are filled in just as
+// csrShortestPaths() fills them in.  The distances are exactly the ones
+// it would find, since every distance is the smallest sum, added up
+// along a path from the source, that any search could arrive at.  Where
+// a vertex has more than one shortest path, though, the predecessor
+// may come from a different one than Dijkstra's algorithm would pick.
+// If a thread fails (which can only happen if it runs out of memory),
+// the exception is rethrown once all of the threads have stopped; if
+// a thread can't be started at all, the search goes on without it.
+
+inline void csrDeltaStepping(
+    const DigraphCsrView& csr, int source, const std::vector<double>& weights, double delta,
+    std::vector<double>& distance, std::vector<int>& predecessor, unsigned threads = 0)
+{
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    // Each light round shares out the bucket's vertices this many at
+    // a time.
+    const std::size_t frontierChunk = 64;
+
+    int n = csr.vertexCount();
+
+    DIGRAPH_STATS_ADD(allocations, distance.capacity() < static_cast<std::size_t>(n));
+    DIGRAPH_STATS_ADD(allocations, predecessor.capacity() < static_cast<std::size_t>(n));
+
+    distance.assign(n, std::numeric_limits<double>::infinity());
+    predecessor.resize(n);
+
+    for (int i = 0; i < n; ++i)
+    {
+        predecessor[i] = i;
+    }
+
+    if (source < 0 || source >= n)
+    {
+        return;
+    }
+
+    if (!(delta > 0.0))
+    {
+        delta = csrDeltaSteppingWidth(csr, weights);
+    }
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    if (n < csrParallelDeltaSteppingThreshold)
+    {
+        threads = 1;
+    }
+
+    // best holds the distances while the search runs, since the threads
+    // read them while others are lowering them; locked holds the spin
+    // locks, and listed marks the vertices already on some thread's
+    // list of vertices to relax the heavy edges of.
+    std::unique_ptr<std::atomic<double>[]> best{new std::atomic<double>[n]};
+    std::unique_ptr<std::atomic<bool>[]> locked{new std::atomic<bool>[n]};
+    std::unique_ptr<std::atomic<bool>[]> listed{new std::atomic<bool>[n]};
+
+    for (int i = 0; i < n; ++i)
+    {
+        best[i].store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+        locked[i].store(false, std::memory_order_relaxed);
+        listed[i].store(false, std::memory_order_relaxed);
+    }
+
+    best[source].store(0.0, std::memory_order_relaxed);
+
+    // Each thread files what it finds in its own Worker, which is
+    // padded so that two threads' bookkeeping never shares a cache line.
+    struct Worker
+    {
+        std::vector<std::vector<int>> buckets;
+        std::vector<int> settled;
+        std::size_t offset;
+        std::exception_ptr failure;
+        char padding[64];
+    };
+
+    std::vector<Worker> workers(threads);
+    workers[0].buckets.resize(1);
+    workers[0].buckets[0].push_back(source);
+
+    auto bucketOf = [delta](double d) { return static_cast<std::size_t>(d / delta); };
+
+    // relax() lowers v's distance to candidate, through u, if that's
+    // shorter than what it has, and files v into the bucket it now
+    // belongs in.
+    auto relax = [&](Worker& worker, int u, int v, double candidate)
+    {
+        DIGRAPH_STATS_ADD(edgesRelaxed, 1);
+
+        if (!(candidate < best[v].load(std::memory_order_relaxed)))
+        {
+            return;
+        }
+
+        while (locked[v].exchange(true, std::memory_order_acquire))
+        {
+            while (locked[v].load(std::memory_order_relaxed))
+            {
+            }
+        }
+
+        bool lowered = candidate < best[v].load(std::memory_order_relaxed);
+
+        if (lowered)
+        {
+            best[v].store(candidate, std::memory_order_relaxed);
+            predecessor[v] = u;
+        }
+
+        locked[v].store(false, std::memory_order_release);
+
+        if (lowered)
+        {
+            std::size_t bucket = bucketOf(candidate);
+
+            if (bucket >= worker.buckets.size())
+            {
+                DIGRAPH_STATS_ADD(allocations, 1);
+                worker.buckets.resize(bucket + 1);
+            }
+
+            worker.buckets[bucket].push_back(v);
+        }
+    };
+
+    std::size_t current = 0;
+    std::vector<int> frontier;
+    std::atomic<std::size_t> nextChunk{0};
+
+    enum class Step { light, heavy, done };
+    Step step = Step::light;
+
+    DigraphBarrier barrier{threads};
+    std::vector<std::thread> helpers;
+
+    // A light step first gathers every thread's share of the current
+    // bucket into the frontier, then relaxes the light edges of the
+    // frontier's vertices whose distances still put them in the bucket.
+    auto relaxLight = [&](unsigned t)
+    {
+        Worker& worker = workers[t];
+
+        if (current < worker.buckets.size())
+        {
+            std::vector<int>& mine = worker.buckets[current];
+            std::copy(mine.begin(), mine.end(), frontier.begin() + worker.offset);
+            mine.clear();
+        }
+
+        barrier.wait();
+
+        for (std::size_t begin = nextChunk.fetch_add(frontierChunk);
+             begin < frontier.size();
+             begin = nextChunk.fetch_add(frontierChunk))
+        {
+            std::size_t end = std::min(begin + frontierChunk, frontier.size());
+
+            for (std::size_t f = begin; f < end; ++f)
+            {
+                int u = frontier[f];
+                double d = best[u].load(std::memory_order_relaxed);
+
+                if (bucketOf(d) != current)
+                {
+                    continue;
+                }
+
+                if (!listed[u].exchange(true, std::memory_order_relaxed))
+                {
+                    worker.settled.push_back(u);
+                }
+
+                for (int e = csr.offsets[u]; e < csr.offsets[u + 1]; ++e)
+                {
+                    if (weights[e] <= delta)
+                    {
+                        relax(worker, u, csr.targets[e], d + weights[e]);
+                    }
+                }
+            }
+        }
+    };
+
+    // A heavy step has each thread relax the heavy edges of the vertices
+    // it settled in the current bucket, whose distances are final now.
+    auto relaxHeavy = [&](unsigned t)
+    {
+        Worker& worker = workers[t];
+
+        DIGRAPH_STATS_ADD(verticesSettled, worker.settled.size());
+
+        for (int u : worker.settled)
+        {
+            listed[u].store(false, std::memory_order_relaxed);
+            double d = best[u].load(std::memory_order_relaxed);
+
+            for (int e = csr.offsets[u]; e < csr.offsets[u + 1]; ++e)
+            {
+                if (weights[e] > delta)
+                {
+                    relax(worker, u, csr.targets[e], d + weights[e]);
+                }
+            }
+        }
+
+        worker.settled.clear();
+    };
+
+    // gather() works out where each thread's share of the current bucket
+    // goes in the frontier, returning false if the bucket is empty.
+    auto gather = [&]
+    {
+        std::size_t total = 0;
+
+        for (Worker& worker : workers)
+        {
+            worker.offset = total;
+
+            if (current < worker.buckets.size())
+            {
+                total += worker.buckets[current].size();
+            }
+        }
+
+        frontier.resize(total);
+        nextChunk.store(0, std::memory_order_relaxed);
+        return total != 0;
+    };
+
+    // plan() decides what the threads do next: another light round if
+    // the last one refilled the current bucket, the heavy step if it
+    // didn't, and after that, a light round on the next bucket that
+    // isn't empty.
+    auto plan = [&]
+    {
+        for (Worker& worker : workers)
+        {
+            if (worker.failure)
+            {
+                step = Step::done;
+                return;
+            }
+        }
+
+        if (step == Step::light)
+        {
+            step = gather() ? Step::light : Step::heavy;
+            return;
+        }
+
+        std::size_t last = 0;
+
+        for (Worker& worker : workers)
+        {
+            last = std::max(last, worker.buckets.size());
+        }
+
+        for (++current; current < last; ++current)
+        {
+            if (gather())
+            {
+                step = Step::light;
+                return;
+            }
+        }
+
+        step = Step::done;
+    };
+
+    auto search = [&](unsigned t)
+    {
+        if (step == Step::light)
+        {
+            relaxLight(t);
+        }
+        else
+        {
+            relaxHeavy(t);
+        }
+    };
+
+    // Each step takes two trips through the barrier: one after thread 0
+    // has planned it, and one after every thread has done it.  (Light
+    // steps take a third, in relaxLight(), once the frontier is full.)
+    // A thread that fails still keeps up with the others, so that none
+    // of them waits forever, and plan() stops the search.
+    auto work = [&](unsigned t)
+    {
+        try
+        {
+            search(t);
+        }
+        catch (...)
+        {
+            workers[t].failure = std::current_exception();
+        }
+    };
+
+    auto help = [&](unsigned t)
+    {
+        for (;;)
+        {
+            barrier.wait();
+
+            if (step == Step::done)
+            {
+                return;
+            }
+
+            work(t);
+            barrier.wait();
+        }
+    };
+
+    gather();
+
+    // If a helper can't be started, the others carry on without it.
+    try
+    {
+        helpers.reserve(threads - 1);
+
+        for (unsigned t = 1; t < threads; ++t)
+        {
+            helpers.emplace_back(help, t);
+        }
+    }
+    catch (...)
+    {
+        barrier.resize(static_cast<unsigned>(helpers.size()) + 1);
+    }
+
+    for (;;)
+    {
+        barrier.wait();
+
+        if (step == Step::done)
+        {
+            break;
+        }
+
+        work(0);
+        barrier.wait();
+
+        try
+        {
+            plan();
+        }
+        catch (...)
+        {
+            workers[0].failure = std::current_exception();
+            step = Step::done;
+        }
+    }
+
+    for (std::thread& helper : helpers)
+    {
+        helper.join();
+    }
+
+    for (Worker& worker : workers)
+    {
+        if (worker.failure)
+        {
+            std::rethrow_exception(worker.failure);
+        }
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        distance[i] = best[i].load(std::memory_order_relaxed);
+    }
+}
+
+
+
+#endif // DIGRAPHDELTASTEPPING_HPP
@@ -0,0 +1,261 @@
+// DigraphFile.hpp
+//
+// This header file describes the binary file format in which Digraphs
+// and FrozenDigraphs are saved, and declares the functions that write
+// and read it.
+//
+// A Digraph file holds a graph in the same compressed sparse row (CSR)
+// layout as a DigraphCsr, followed by its VertexInfo and EdgeInfo
+// objects, each stored as raw bytes.  That means only graphs whose info
+// types are trivially copyable can be saved, and that a file can only
+// be read on a machine with the same byte order and type layouts as the
+// one that wrote it; the header records enough to detect a mismatch.
+//
+// The file is laid out as follows, with every section starting at a
+// multiple of 64 bytes from the beginning of the file:
+//
+// * a DigraphFileHeader
+// * the vertex numbers, as vertexCount ints in ascending order
+// * the CSR offsets, as vertexCount + 1 ints
+// * the CSR targets, as edgeCount ints
+// * the VertexInfo objects, one per vertex in the same order
+// * the EdgeInfo objects, one per edge in the same order as the targets
+//
+// Because the sections are already in the shape the algorithms want,
+// a mapped file can be used where it lies, with no parsing at all; it
+// only needs one pass over the vertex numbers, offsets and targets to
+// make sure a damaged file can't send a query outside of the arrays.
+
+#ifndef DIGRAPHFILE_HPP
+#define DIGRAPHFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include "DigraphCsr.hpp"
+#include "MappedFile.hpp"
+
+
+
+struct DigraphFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t vertexInfoSize;
+    std::uint32_t edgeInfoSize;
+    std::uint64_t vertexCount;
+    std::uint64_t edgeCount;
+    std::uint64_t numbersAt;
+    std::uint64_t offsetsAt;
+    std::uint64_t targetsAt;
+    std::uint64_t vertexInfosAt;
+    std::uint64_t edgeInfosAt;
+    std::uint64_t fileSize;
+};
+
+
+const char digraphFileMagic[8] = {'D', 'I', 'G', 'R', 'A', 'P', 'H', '\0'};
+const std::uint32_t digraphFileVersion = 1;
+const std::uint32_t digraphFileByteOrder = 0x01020304;
+
+
+
+// digraphFileLayout() returns the header of a file holding a graph with
+// the given numbers of vertices and edges and the given info sizes.
+
+inline DigraphFileHeader digraphFileLayout(
+    std::uint64_t vertexCount, std::uint64_t edgeCount,
+    std::size_t vertexInfoSize, std::size_t edgeInfoSize)
+{
+    auto align = [](std::uint64_t at) { return (at + 63) & ~static_cast<std::uint64_t>(63); };
+
+    DigraphFileHeader header;
+    std::memcpy(header.magic, digraphFileMagic, sizeof(header.magic));
+    header.version = digraphFileVersion;
+    header.byteOrder = digraphFileByteOrder;
+    header.vertexInfoSize = static_cast<std::uint32_t>(vertexInfoSize);
+    header.edgeInfoSize = static_cast<std::uint32_t>(edgeInfoSize);
+    header.vertexCount = vertexCount;
+    header.edgeCount = edgeCount;
+    header.numbersAt = align(sizeof(DigraphFileHeader));
+    header.offsetsAt = align(header.numbersAt + vertexCount * sizeof(int));
+    header.targetsAt = align(header.offsetsAt + (vertexCount + 1) * sizeof(int));
+    header.vertexInfosAt = align(header.targetsAt + edgeCount * sizeof(int));
+    header.edgeInfosAt = align(header.vertexInfosAt + vertexCount * vertexInfoSize);
+    header.fileSize = header.edgeInfosAt + edgeCount * edgeInfoSize;
+    return header;
+}
+
+
+
+// writeDigraphFile() writes the graph with the given topology to the
+// file with the given path.  vertexInfoAt(i) and edgeInfoAt(e) must
+// return the VertexInfo of the vertex with dense index i and the
+// EdgeInfo of the edge with index e in csr.targets.  It returns false
+// if the file couldn't be written.
+
+template <typename VertexInfo, typename EdgeInfo, typename VertexInfoAt, typename EdgeInfoAt>
+bool writeDigraphFile(
+    const std::string& path, const DigraphCsrView& csr,
+    VertexInfoAt&& vertexInfoAt, EdgeInfoAt&& edgeInfoAt)
+{
+    static_assert(std::is_trivially_copyable<VertexInfo>::value,
+                  "Only graphs with trivially copyable VertexInfo can be saved");
+    static_assert(std::is_trivially_copyable<EdgeInfo>::value,
+                  "Only graphs with trivially copyable EdgeInfo can be saved");
+
+    DigraphFileHeader header = digraphFileLayout(
+        csr.vertexCount(), csr.edgeCount(), sizeof(VertexInfo), sizeof(EdgeInfo));
+
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    std::uint64_t at = 0;
+
+    auto write = [&](const void* bytes, std::uint64_t length)
+    {
+        out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(length));
+        at += length;
+    };
+
+    auto padTo = [&](std::uint64_t section)
+    {
+        static const char zeros[64] = {};
+        write(zeros, section - at);
+    };
+
+    write(&header, sizeof(header));
+    padTo(header.numbersAt);
+    write(csr.numbers, csr.vertexCount() * sizeof(int));
+    padTo(header.offsetsAt);
+    write(csr.offsets, (csr.vertexCount() + 1) * sizeof(int));
+    padTo(header.targetsAt);
+    write(csr.targets, csr.edgeCount() * sizeof(int));
+    padTo(header.vertexInfosAt);
+
+    for (int i = 0; i < csr.vertexCount(); ++i)
+    {
+        const VertexInfo& vinfo = vertexInfoAt(i);
+        write(&vinfo, sizeof(VertexInfo));
+    }
+
+    padTo(header.edgeInfosAt);
+
+    for (int e = 0; e < csr.edgeCount(); ++e)
+    {
+        const EdgeInfo& einfo = edgeInfoAt(e);
+        write(&einfo, sizeof(EdgeInfo));
+    }
+
+    out.close();
+    return !out.fail();
+}
+
+
+
+// readDigraphFile() checks that the given file holds a graph with the
+// given info types and, if it does, points csr, vinfos and einfos at
+// the sections of the file and returns nullptr.  Otherwise, it returns
+// a description of what's wrong with the file.  Nothing is copied, so
+// the results are only good as long as the file stays open.
+//
+// Besides the header, it checks everything the algorithms rely on to
+// stay inside the arrays: that the vertex numbers are strictly
+// ascending (indexOf() searches them by bisection), that the offsets
+// run from 0 to the edge count without ever going down, and that every
+// target is a vertex index.  The info objects aren't checked, since
+// any bytes make a valid trivially copyable object.
+
+template <typename VertexInfo, typename EdgeInfo>
+const char* readDigraphFile(
+    const MappedFile& file, DigraphCsrView& csr,
+    const VertexInfo*& vinfos, const EdgeInfo*& einfos)
+{
+    static_assert(std::is_trivially_copyable<VertexInfo>::value,
+                  "Only graphs with trivially copyable VertexInfo can be loaded");
+    static_assert(std::is_trivially_copyable<EdgeInfo>::value,
+                  "Only graphs with trivially copyable EdgeInfo can be loaded");
+
+    DigraphFileHeader header;
+
+    if (!file.isOpen() || file.size() < sizeof(header))
+    {
+        return "not a Digraph file";
+    }
+
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, digraphFileMagic, sizeof(header.magic)) != 0)
+    {
+        return "not a Digraph file";
+    }
+
+    if (header.version != digraphFileVersion)
+    {
+        return "unsupported Digraph file version";
+    }
+
+    if (header.byteOrder != digraphFileByteOrder)
+    {
+        return "Digraph file was written with a different byte order";
+    }
+
+    if (header.vertexInfoSize != sizeof(VertexInfo) || header.edgeInfoSize != sizeof(EdgeInfo))
+    {
+        return "Digraph file holds different vertex or edge info types";
+    }
+
+    if (header.vertexCount > static_cast<std::uint64_t>(std::numeric_limits<int>::max())
+        || header.edgeCount > static_cast<std::uint64_t>(std::numeric_limits<int>::max()))
+    {
+        return "Digraph file is corrupt";
+    }
+
+    DigraphFileHeader expected = digraphFileLayout(
+        header.vertexCount, header.edgeCount, sizeof(VertexInfo), sizeof(EdgeInfo));
+
+    if (std::memcmp(&header, &expected, sizeof(header)) != 0 || file.size() < header.fileSize)
+    {
+        return "Digraph file is corrupt";
+    }
+
+    const char* base = file.data();
+
+    csr.numbers = reinterpret_cast<const int*>(base + header.numbersAt);
+    csr.offsets = reinterpret_cast<const int*>(base + header.offsetsAt);
+    csr.targets = reinterpret_cast<const int*>(base + header.targetsAt);
+    csr.vertices = static_cast<int>(header.vertexCount);
+    csr.edges = static_cast<int>(header.edgeCount);
+    vinfos = reinterpret_cast<const VertexInfo*>(base + header.vertexInfosAt);
+    einfos = reinterpret_cast<const EdgeInfo*>(base + header.edgeInfosAt);
+
+    if (csr.offsets[0] != 0 || csr.offsets[csr.vertices] != csr.edges)
+    {
+        return "Digraph file is corrupt";
+    }
+
+    for (int i = 0; i < csr.vertices; ++i)
+    {
+        if ((i > 0 && csr.numbers[i - 1] >= csr.numbers[i]) || csr.offsets[i] > csr.offsets[i + 1])
+        {
+            return "Digraph file is corrupt";
+        }
+    }
+
+    for (int e = 0; e < csr.edges; ++e)
+    {
+        if (csr.targets[e] < 0 || csr.targets[e] >= csr.vertices)
+        {
+            return "Digraph file is corrupt";
+        }
+    }
+
+    return nullptr;
+}
+
+
+
+#endif // DIGRAPHFILE_HPP
@@ -0,0 +1,248 @@
+// DigraphPool.hpp
+//
+// This header file declares DigraphPool, a memory pool for the many
+// small nodes a Digraph allocates (one per vertex in its std::map and
+// one per edge in a std::list), and DigraphPoolAllocator, a standard
+// allocator that draws its memory from a DigraphPool.
+//
+// A DigraphPool carves small objects out of large blocks, sorting them
+// by size into classes 16 bytes apart, and keeps a free list for each
+// class so that freed nodes are reused by later allocations of the
+// same size.  Requests bigger than the largest class go straight to
+// operator new.  The blocks are only given back when the pool itself
+// is destroyed, which happens all at once.
+//
+// To build a Digraph out of a pool, name the allocator as its third
+// type parameter:
+//
+//     Digraph<VertexInfo, EdgeInfo, DigraphPoolAllocator<char>> d;
+//
+// Each default-constructed DigraphPoolAllocator makes a fresh pool.
+// Copies of an allocator (including the rebound copies the containers
+// inside a Digraph make, and the allocator of a copied Digraph) share
+// their original's pool.  A pool is no safer to use from more than one
+// thread at once than the Digraph it belongs to.
+
+#ifndef DIGRAPHPOOL_HPP
+#define DIGRAPHPOOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+
+
+class DigraphPool
+{
+public:
+    // The constructor initializes an empty pool.  Blocks start out at
+    // firstBlockSize bytes and double in size up to a megabyte as the
+    // pool grows.
+    explicit DigraphPool(std::size_t firstBlockSize = 4096);
+
+    // The destructor releases every block at once, whether or not the
+    // objects in them were deallocated.
+    ~DigraphPool() noexcept;
+
+    DigraphPool(const DigraphPool&) = delete;
+    DigraphPool& operator=(const DigraphPool&) = delete;
+
+    // allocate() returns memory for an object of the given size, and
+    // deallocate() returns that memory to the pool.  The size passed to
+    // deallocate() must be the one passed to allocate().
+    void* allocate(std::size_t bytes);
+    void deallocate(void* p, std::size_t bytes) noexcept;
+
+
+private:
+    static const std::size_t granularity = 16;
+    static const std::size_t largestPooled = 512;
+    static const std::size_t largestBlock = 1 << 20;
+
+    struct FreeNode
+    {
+        FreeNode* next;
+    };
+
+    std::vector<FreeNode*> freeLists;
+    std::vector<char*> blocks;
+    char* cursor;
+    char* limit;
+    std::size_t nextBlockSize;
+};
+
+
+
+inline DigraphPool::DigraphPool(std::size_t firstBlockSize)
+    : freeLists(largestPooled / granularity, nullptr),
+      cursor{nullptr}, limit{nullptr}, nextBlockSize{firstBlockSize}
+{
+}
+
+
+inline DigraphPool::~DigraphPool() noexcept
+{
+    for (char* block : blocks)
+    {
+        ::operator delete(block);
+    }
+}
+
+
+inline void* DigraphPool::allocate(std::size_t bytes)
+{
+    if (bytes > largestPooled)
+    {
+        return ::operator new(bytes);
+    }
+
+    std::size_t sizeClass = bytes == 0 ? 0 : (bytes - 1) / granularity;
+
+    if (freeLists[sizeClass] != nullptr)
+    {
+        FreeNode* node = freeLists[sizeClass];
+        freeLists[sizeClass] = node->next;
+        return node;
+    }
+
+    std::size_t size = (sizeClass + 1) * granularity;
+
+    if (static_cast<std::size_t>(limit - cursor) < size)
+    {
+        // Whatever is left at the end of the old block is abandoned;
+        // it is always smaller than the largest size class.
+        blocks.reserve(blocks.size() + 1);
+        cursor = static_cast<char*>(::operator new(nextBlockSize));
+        limit = cursor + nextBlockSize;
+        blocks.push_back(cursor);
+
+        if (nextBlockSize < largestBlock)
+        {
+            nextBlockSize *= 2;
+        }
+    }
+
+    void* p = cursor;
+    cursor += size;
+    return p;
+}
+
+
+inline void DigraphPool::deallocate(void* p, std::size_t bytes) noexcept
+{
+    if (bytes > largestPooled)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    std::size_t sizeClass = bytes == 0 ? 0 : (bytes - 1) / granularity;
+    FreeNode* node = static_cast<FreeNode*>(p);
+    node->next = freeLists[sizeClass];
+    freeLists[sizeClass] = node;
+}
+
+
+
+template <typename T>
+class DigraphPoolAllocator
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "DigraphPool can't hand out over-aligned memory");
+
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    // The default constructor makes a new pool; the others share the
+    // given allocator's pool.
+    DigraphPoolAllocator();
+    explicit DigraphPoolAllocator(std::shared_ptr<DigraphPool> pool) noexcept;
+    DigraphPoolAllocator(const DigraphPoolAllocator& other) noexcept;
+
+    template <typename U>
+    DigraphPoolAllocator(const DigraphPoolAllocator<U>& other) noexcept;
+
+    T* allocate(std::size_t n);
+    void deallocate(T* p, std::size_t n) noexcept;
+
+    // pool() returns the pool this allocator draws from.
+    const std::shared_ptr<DigraphPool>& pool() const noexcept;
+
+
+private:
+    std::shared_ptr<DigraphPool> shared;
+};
+
+
+
+template <typename T>
+DigraphPoolAllocator<T>::DigraphPoolAllocator()
+    : shared{std::make_shared<DigraphPool>()}
+{
+}
+
+
+template <typename T>
+DigraphPoolAllocator<T>::DigraphPoolAllocator(std::shared_ptr<DigraphPool> pool) noexcept
+    : shared{std::move(pool)}
+{
+}
+
+
+template <typename T>
+DigraphPoolAllocator<T>::DigraphPoolAllocator(const DigraphPoolAllocator& other) noexcept
+    : shared{other.pool()}
+{
+}
+
+
+template <typename T>
+template <typename U>
+DigraphPoolAllocator<T>::DigraphPoolAllocator(const DigraphPoolAllocator<U>& other) noexcept
+    : shared{other.pool()}
+{
+}
+
+
+template <typename T>
+T* DigraphPoolAllocator<T>::allocate(std::size_t n)
+{
+    return static_cast<T*>(shared->allocate(n * sizeof(T)));
+}
+
+
+template <typename T>
+void DigraphPoolAllocator<T>::deallocate(T* p, std::size_t n) noexcept
+{
+    shared->deallocate(p, n * sizeof(T));
+}
+
+
+template <typename T>
+const std::shared_ptr<DigraphPool>& DigraphPoolAllocator<T>::pool() const noexcept
+{
+    return shared;
+}
+
+
+template <typename T, typename U>
+bool operator==(const DigraphPoolAllocator<T>& a, const DigraphPoolAllocator<U>& b) noexcept
+{
+    return a.pool() == b.pool();
+}
+
+
+template <typename T, typename U>
+bool operator!=(const DigraphPoolAllocator<T>& a, const DigraphPoolAllocator<U>& b) noexcept
+{
+    return !(a == b);
+}
+
+
+
+#endif // DIGRAPHPOOL_HPP
@@ -0,0 +1,286 @@
+// DigraphRoute.hpp
+//
+// This header file declares DigraphRoute, the result of a point-to-point
+// shortest path query, and the two searches that answer one without
+// working out the shortest paths to every other vertex:
+//
+// * routeBidirectional(), which runs Dijkstra's algorithm forward from
+//   the start vertex and backward from the end vertex at the same time,
+//   stopping once the two searches can't find anything shorter than
+//   the best path where they've met
+// * routeAStar(), which runs a forward search guided by a heuristic
+//   estimate of each vertex's remaining distance to the end vertex,
+//   stopping as soon as the end vertex is settled
+//
+// Both searches see the graph only through callbacks that list a
+// vertex's edges, so they work on vertex numbers directly and only keep
+// track of the vertices they actually reach; a query whose answer is
+// nearby costs little however big the graph is.
+
+#ifndef DIGRAPHROUTE_HPP
+#define DIGRAPHROUTE_HPP
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "DigraphStats.hpp"
+
+
+
+// A DigraphRoute describes a shortest path between two vertices.
+//
+// * path lists the vertex numbers along it, from the start vertex to
+//   the end vertex inclusive, and is empty if there is no path
+// * cost is the path's total weight, or infinity if there is no path
+// * settled is the number of vertices whose distance the search had to
+//   settle to find it, a measure of how much work the query took
+
+struct DigraphRoute
+{
+    std::vector<int> path;
+    double cost;
+    int settled;
+};
+
+
+
+// A DigraphRouteLabel is what a search knows about a vertex it has
+// reached: its best known distance, the vertex it was reached from (in
+// a backward search, the next vertex toward the end), and whether that
+// distance is final.
+
+struct DigraphRouteLabel
+{
+    double distance;
+    int via;
+    bool settled;
+};
+
+
+typedef std::unordered_map<int, DigraphRouteLabel> DigraphRouteLabels;
+
+// The callbacks list a vertex's edges as (vertex number, weight) pairs
+// in a DigraphRouteEdges, which the searches reuse from one vertex to
+// the next.
+typedef std::vector<std::pair<int, double>> DigraphRouteEdges;
+
+typedef std::priority_queue<
+    std::pair<double, int>, std::vector<std::pair<double, int>>,
+    std::greater<std::pair<double, int>>> DigraphRouteQueue;
+
+
+
+// routeFollow() appends to path the vertices reached by following the
+// via links in labels from the given vertex, not including the vertex
+// itself, until it comes to a vertex that is its own via.
+
+inline void routeFollow(const DigraphRouteLabels& labels, int vertex, std::vector<int>& path)
+{
+    for (int v = labels.find(vertex)->second.via; v != vertex; v = labels.find(v)->second.via)
+    {
+        path.push_back(v);
+        vertex = v;
+    }
+}
+
+
+
+// routeBidirectional() finds a shortest path from source to target.
+// outEdges(u, edges) must append (v, weight) to edges for every edge
+// from u to v, and inEdges(v, edges) must append (u, weight) for every
+// edge from u to v; weights must be non-negative.
+
+template <typename OutEdges, typename InEdges>
+DigraphRoute routeBidirectional(int source, int target, OutEdges&& outEdges, InEdges&& inEdges)
+{
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    DigraphRouteLabels labels[2];
+    DigraphRouteQueue queues[2];
+
+    labels[0][source] = DigraphRouteLabel{0.0, source, false};
+    labels[1][target] = DigraphRouteLabel{0.0, target, false};
+    queues[0].emplace(0.0, source);
+    queues[1].emplace(0.0, target);
+
+    // best is the length of the shortest path seen so far, which runs
+    // through meeting.
+    double best = source == target ? 0.0 : infinity;
+    int meeting = source;
+    int settled = 0;
+    DigraphRouteEdges edges;
+
+    // Whenever either search improves a vertex's distance, the vertex is
+    // checked against the other search, so every place the two could
+    // meet is considered.
+    auto relax = [&](int side, int v, int via, double distance)
+    {
+        DIGRAPH_STATS_ADD(edgesRelaxed, 1);
+        DIGRAPH_STATS_ADD(hashProbes, 1);
+
+        auto found = labels[side].find(v);
+
+        if (found != labels[side].end() && found->second.distance <= distance)
+        {
+            return;
+        }
+
+        labels[side][v] = DigraphRouteLabel{distance, via, false};
+        queues[side].emplace(distance, v);
+
+        DIGRAPH_STATS_ADD(hashProbes, 2);
+        DIGRAPH_STATS_ADD(heapPushes, 1);
+
+        auto other = labels[1 - side].find(v);
+
+        if (other != labels[1 - side].end() && distance + other->second.distance < best)
+        {
+            best = distance + other->second.distance;
+            meeting = v;
+        }
+    };
+
+    while (!queues[0].empty() && !queues[1].empty()
+           && queues[0].top().first + queues[1].top().first < best)
+    {
+        // Expanding whichever search has less waiting keeps the two
+        // roughly balanced.
+        int side = queues[0].size() <= queues[1].size() ? 0 : 1;
+
+        std::pair<double, int> next = queues[side].top();
+        queues[side].pop();
+
+        DigraphRouteLabel& label = labels[side][next.second];
+
+        DIGRAPH_STATS_ADD(heapPops, 1);
+        DIGRAPH_STATS_ADD(hashProbes, 1);
+
+        if (label.settled || next.first > label.distance)
+        {
+            continue;
+        }
+
+        label.settled = true;
+        ++settled;
+        DIGRAPH_STATS_ADD(verticesSettled, 1);
+
+        int u = next.second;
+        edges.clear();
+
+        if (side == 0)
+        {
+            outEdges(u, edges);
+        }
+        else
+        {
+            inEdges(u, edges);
+        }
+
+        for (const std::pair<int, double>& edge : edges)
+        {
+            relax(side, edge.first, u, next.first + edge.second);
+        }
+    }
+
+    DigraphRoute route{std::vector<int>{}, best, settled};
+
+    if (best < infinity)
+    {
+        route.path.push_back(meeting);
+        routeFollow(labels[0], meeting, route.path);
+        std::reverse(route.path.begin(), route.path.end());
+        routeFollow(labels[1], meeting, route.path);
+    }
+
+    return route;
+}
+
+
+
+// routeAStar() finds a shortest path from source to target.
+// outEdges(u, edges) must append (v, weight) to edges for every edge
+// from u to v, with non-negative weights, and estimate(v) must return a
+// lower bound on the length of the shortest path from v to target.
+// The estimate must also be consistent (for every edge from u to v,
+// estimate(u) <= weight + estimate(v)), or the path found may not be
+// the shortest; straight-line distance between coordinates is.
+
+template <typename OutEdges, typename Estimate>
+DigraphRoute routeAStar(int source, int target, OutEdges&& outEdges, Estimate&& estimate)
+{
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    DigraphRouteLabels labels;
+    DigraphRouteQueue queue;
+    DigraphRouteEdges edges;
+
+    labels[source] = DigraphRouteLabel{0.0, source, false};
+    queue.emplace(estimate(source), source);
+
+    DigraphRoute route{std::vector<int>{}, std::numeric_limits<double>::infinity(), 0};
+
+    while (!queue.empty())
+    {
+        int u = queue.top().second;
+        queue.pop();
+
+        DigraphRouteLabel& label = labels[u];
+
+        DIGRAPH_STATS_ADD(heapPops, 1);
+        DIGRAPH_STATS_ADD(hashProbes, 1);
+
+        if (label.settled)
+        {
+            continue;
+        }
+
+        label.settled = true;
+        ++route.settled;
+        DIGRAPH_STATS_ADD(verticesSettled, 1);
+
+        double d = label.distance;
+
+        if (u == target)
+        {
+            route.cost = d;
+            route.path.push_back(target);
+            routeFollow(labels, target, route.path);
+            std::reverse(route.path.begin(), route.path.end());
+            break;
+        }
+
+        edges.clear();
+        outEdges(u, edges);
+
+        for (const std::pair<int, double>& edge : edges)
+        {
+            int v = edge.first;
+            double distance = d + edge.second;
+            auto found = labels.find(v);
+
+            DIGRAPH_STATS_ADD(edgesRelaxed, 1);
+            DIGRAPH_STATS_ADD(hashProbes, 1);
+
+            if (found == labels.end() || distance < found->second.distance)
+            {
+                labels[v] = DigraphRouteLabel{distance, u, false};
+                queue.emplace(distance + estimate(v), v);
+
+                DIGRAPH_STATS_ADD(hashProbes, 1);
+                DIGRAPH_STATS_ADD(heapPushes, 1);
+            }
+        }
+    }
+
+    return route;
+}
+
+
+
+#endif // DIGRAPHROUTE_HPP
@@ -0,0 +1,209 @@
+// DigraphShortestPaths.hpp
+//
+// This header file declares csrShortestPathsMany(), which runs
+// Dijkstra's Shortest Path Algorithm from many sources at once on a
+// team of threads, DigraphPathMatrix, the dense table of distances
+// and predecessors it fills in, and DigraphEdgeWeights, a graph's edge
+// weights worked out ahead of time.
+//
+// The sources are independent, so the threads simply take the next
+// unclaimed source whenever they finish one; a thread that draws a few
+// expensive sources doesn't hold the others up.  Each thread keeps one
+// set of scratch arrays and one heap for all of the sources it runs.
+
+#ifndef DIGRAPHSHORTESTPATHS_HPP
+#define DIGRAPHSHORTESTPATHS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "DigraphCsr.hpp"
+#include "IndexedHeap.hpp"
+
+
+
+// A DigraphPathMatrix holds the results of a shortest path search from
+// each of several sources, one row per source and one column per
+// vertex, with the columns in ascending order of vertex number.
+//
+// * sources lists the vertex number of each row's source
+// * vertices lists the vertex number of each column's vertex
+// * distance holds the rows of distances one after the other (the
+//   distance from source r to the vertex in column c is
+//   distance[r * vertices.size() + c]), with infinity for vertices the
+//   source can't reach
+// * predecessor is laid out the same way and holds the column of the
+//   vertex before each vertex on its shortest path, or -1 for the
+//   source itself and for vertices it can't reach
+
+struct DigraphPathMatrix
+{
+    std::vector<int> sources;
+    std::vector<int> vertices;
+    std::vector<double> distance;
+    std::vector<int> predecessor;
+
+    // distanceAt() and predecessorAt() look up a single entry by row
+    // and column.
+    double distanceAt(int row, int column) const noexcept;
+    int predecessorAt(int row, int column) const noexcept;
+};
+
+
+
+// A DigraphEdgeWeights holds a weight for every edge of a
+// FrozenDigraph, in the same order as its csr().targets, so that a
+// weight function can be run over the graph once and the results used
+// by any number of queries (see FrozenDigraph::edgeWeights()).
+
+struct DigraphEdgeWeights
+{
+    std::vector<double> weight;
+};
+
+
+// DigraphWeightFunction<WeightFn> is void when WeightFn is a weight
+// function and doesn't exist when it's a DigraphEdgeWeights, which
+// keeps the templated findShortestPaths() overloads from claiming
+// calls meant for the ones that take precomputed weights.
+
+template <typename WeightFn>
+using DigraphWeightFunction = typename std::enable_if<
+    !std::is_same<typename std::decay<WeightFn>::type, DigraphEdgeWeights>::value>::type;
+
+
+
+inline double DigraphPathMatrix::distanceAt(int row, int column) const noexcept
+{
+    return distance[static_cast<std::size_t>(row) * vertices.size() + column];
+}
+
+
+inline int DigraphPathMatrix::predecessorAt(int row, int column) const noexcept
+{
+    return predecessor[static_cast<std::size_t>(row) * vertices.size() + column];
+}
+
+
+
+// csrShortestPathsMany() fills in paths with the shortest paths from
+// each of the given source indices, using the given number of threads
+// (or, if it's zero, one per hardware thread).  weights[e] must be the
+// non-negative weight of the edge with index e in csr.targets.  If a
+// thread fails (which can only happen if it runs out of memory), or a
+// thread can't be started, the exception is rethrown once all of the
+// threads have stopped.
+
+inline void csrShortestPathsMany(
+    const DigraphCsrView& csr, const std::vector<int>& sources,
+    const std::vector<double>& weights, DigraphPathMatrix& paths,
+    unsigned threads = 0)
+{
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    int n = csr.vertexCount();
+    int rows = static_cast<int>(sources.size());
+
+    paths.sources.resize(rows);
+    paths.vertices.assign(csr.numbers, csr.numbers + n);
+    paths.distance.resize(static_cast<std::size_t>(rows) * n);
+    paths.predecessor.resize(static_cast<std::size_t>(rows) * n);
+
+    for (int r = 0; r < rows; ++r)
+    {
+        paths.sources[r] = csr.numbers[sources[r]];
+    }
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    threads = static_cast<unsigned>(std::min<long long>(threads, std::max(rows, 1)));
+
+    struct Worker
+    {
+        std::vector<double> distance;
+        std::vector<int> predecessor;
+        IndexedHeap<double> heap;
+        std::exception_ptr failure;
+    };
+
+    std::vector<Worker> workers(threads);
+    std::atomic<int> nextRow{0};
+
+    auto work = [&](unsigned t)
+    {
+        Worker& worker = workers[t];
+
+        try
+        {
+            for (int r = nextRow++; r < rows; r = nextRow++)
+            {
+                csrShortestPaths(
+                    csr, sources[r], [&](int e) { return weights[e]; },
+                    worker.distance, worker.predecessor, worker.heap);
+
+                std::size_t row = static_cast<std::size_t>(r) * n;
+                std::copy(worker.distance.begin(), worker.distance.end(), paths.distance.begin() + row);
+
+                for (int i = 0; i < n; ++i)
+                {
+                    int p = worker.predecessor[i];
+                    paths.predecessor[row + i] = p == i ? -1 : p;
+                }
+            }
+        }
+        catch (...)
+        {
+            worker.failure = std::current_exception();
+            nextRow = rows;
+        }
+    };
+
+    std::vector<std::thread> helpers;
+
+    // If a helper can't be started, the ones that were are stopped
+    // before the failure is passed on.
+    try
+    {
+        for (unsigned t = 1; t < threads; ++t)
+        {
+            helpers.emplace_back(work, t);
+        }
+    }
+    catch (...)
+    {
+        nextRow = rows;
+
+        for (std::thread& helper : helpers)
+        {
+            helper.join();
+        }
+
+        throw;
+    }
+
+    work(0);
+
+    for (std::thread& helper : helpers)
+    {
+        helper.join();
+    }
+
+    for (Worker& worker : workers)
+    {
+        if (worker.failure)
+        {
+            std::rethrow_exception(worker.failure);
+        }
+    }
+}
+
+
+
+#endif // DIGRAPHSHORTESTPATHS_HPP
@@ -0,0 +1,240 @@
+// DigraphStats.hpp
+//
+// This header file declares DigraphStats, a set of counters and timers
+// describing the work a graph algorithm did, and the few pieces needed
+// to collect them:
+//
+// * DigraphStatsScope, which makes a DigraphStats the one the calling
+//   thread's algorithms report to for as long as the scope lives
+// * digraphMeasure(), which runs a callable inside such a scope and
+//   returns what it recorded
+// * DIGRAPH_STATS_ADD() and DIGRAPH_STATS_PHASE(), which the algorithms
+//   use to record what they do
+//
+// Collecting statistics costs a little on every heap operation and
+// every edge relaxation, so it is switched off unless DIGRAPH_STATS is
+// defined (say, with -DDIGRAPH_STATS) before any of the Digraph headers
+// are included.  When it isn't, the macros expand to nothing, the scope
+// does nothing, and the counters all stay zero; the algorithms compile
+// to exactly what they would without this header.
+//
+// For example:
+//
+//     DigraphStats stats;
+//
+//     {
+//         DigraphStatsScope scope{stats};
+//         d.findShortestPaths(1, weight);
+//     }
+//
+//     std::cout << stats.heapPops << " pops, " << stats.searchSeconds << "s\n";
+//
+// Only the thread that opened the scope reports to it; the helper
+// threads of the parallel algorithms (findShortestPathsMany(), parallel
+// breadth-first search, delta-stepping, ContractionHierarchy's
+// preprocessing) don't, so their stats describe the calling thread's
+// share of the work.
+
+#ifndef DIGRAPHSTATS_HPP
+#define DIGRAPHSTATS_HPP
+
+#ifdef DIGRAPH_STATS
+#include <chrono>
+#endif
+
+
+
+// A DigraphStats describes the work done by the algorithms that ran
+// while it was in scope.
+//
+// * verticesSettled counts the vertices whose final distance (or, for
+//   searches without distances, whose visit) an algorithm settled
+// * edgesRelaxed counts the edges an algorithm examined
+// * heapPushes, heapPops and heapDecreases count priority queue
+//   operations
+// * mapProbes counts lookups in a Digraph's std::map of vertices
+// * hashProbes counts slots examined in a Digraph's edge hash table
+//   (and in the hash tables of the point-to-point searches)
+// * allocations counts the times an algorithm had to allocate or grow
+//   one of its working arrays, rather than reusing one it already had
+// * buildSeconds is the time spent packing a Digraph into the arrays
+//   the algorithms run on, searchSeconds the time spent in the
+//   algorithms themselves, and resultSeconds the time spent turning
+//   their answers back into std::maps of vertex numbers
+
+struct DigraphStats
+{
+    long long verticesSettled = 0;
+    long long edgesRelaxed = 0;
+    long long heapPushes = 0;
+    long long heapPops = 0;
+    long long heapDecreases = 0;
+    long long mapProbes = 0;
+    long long hashProbes = 0;
+    long long allocations = 0;
+    double buildSeconds = 0.0;
+    double searchSeconds = 0.0;
+    double resultSeconds = 0.0;
+};
+
+
+
+// A DigraphStatsScope clears the given DigraphStats and has the calling
+// thread's algorithms report to it until the scope ends, when whatever
+// DigraphStats was being reported to before takes over again.
+
+class DigraphStatsScope
+{
+public:
+    explicit DigraphStatsScope(DigraphStats& stats) noexcept;
+    ~DigraphStatsScope() noexcept;
+
+    DigraphStatsScope(const DigraphStatsScope&) = delete;
+    DigraphStatsScope& operator=(const DigraphStatsScope&) = delete;
+
+
+private:
+#ifdef DIGRAPH_STATS
+    DigraphStats* previous;
+#endif
+};
+
+
+
+// digraphMeasure() calls call() in a DigraphStatsScope of its own and
+// returns the stats it collected.
+
+template <typename Call>
+DigraphStats digraphMeasure(Call&& call)
+{
+    DigraphStats stats;
+    DigraphStatsScope scope{stats};
+    call();
+    return stats;
+}
+
+
+
+#ifdef DIGRAPH_STATS
+
+
+// digraphActiveStats() returns the calling thread's current
+// DigraphStats, or nullptr if it isn't in a DigraphStatsScope.
+
+inline DigraphStats*& digraphActiveStats() noexcept
+{
+    static thread_local DigraphStats* active = nullptr;
+    return active;
+}
+
+
+// A DigraphStatsTimer adds the time from its construction to its
+// destruction to one of the phase times of the calling thread's
+// DigraphStats, if it has one.  Timers don't nest: an algorithm only
+// times the phase it's in when nothing that called it already is.
+
+class DigraphStatsTimer
+{
+public:
+    explicit DigraphStatsTimer(double DigraphStats::* phase) noexcept;
+    ~DigraphStatsTimer() noexcept;
+
+    DigraphStatsTimer(const DigraphStatsTimer&) = delete;
+    DigraphStatsTimer& operator=(const DigraphStatsTimer&) = delete;
+
+
+private:
+    static bool& running() noexcept;
+
+    double DigraphStats::* phase;
+    bool timing;
+    std::chrono::steady_clock::time_point start;
+};
+
+
+#define DIGRAPH_STATS_ADD(field, amount) \
+    do \
+    { \
+        if (DigraphStats* digraphStats_ = digraphActiveStats()) \
+        { \
+            digraphStats_->field += (amount); \
+        } \
+    } \
+    while (false)
+
+#define DIGRAPH_STATS_PHASE(field) \
+    DigraphStatsTimer digraphStatsTimer_(&DigraphStats::field)
+
+
+
+inline DigraphStatsScope::DigraphStatsScope(DigraphStats& stats) noexcept
+    : previous{digraphActiveStats()}
+{
+    stats = DigraphStats{};
+    digraphActiveStats() = &stats;
+}
+
+
+inline DigraphStatsScope::~DigraphStatsScope() noexcept
+{
+    digraphActiveStats() = previous;
+}
+
+
+
+inline DigraphStatsTimer::DigraphStatsTimer(double DigraphStats::* phase) noexcept
+    : phase{phase}, timing{digraphActiveStats() != nullptr && !running()}
+{
+    if (timing)
+    {
+        running() = true;
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+
+inline DigraphStatsTimer::~DigraphStatsTimer() noexcept
+{
+    if (timing)
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        running() = false;
+
+        if (DigraphStats* stats = digraphActiveStats())
+        {
+            stats->*phase += elapsed.count();
+        }
+    }
+}
+
+
+inline bool& DigraphStatsTimer::running() noexcept
+{
+    static thread_local bool running = false;
+    return running;
+}
+
+
+#else
+
+
+#define DIGRAPH_STATS_ADD(field, amount) do { } while (false)
+#define DIGRAPH_STATS_PHASE(field) do { } while (false)
+
+
+inline DigraphStatsScope::DigraphStatsScope(DigraphStats& stats) noexcept
+{
+    stats = DigraphStats{};
+}
+
+
+inline DigraphStatsScope::~DigraphStatsScope() noexcept
+{
+}
+
+
+#endif
+
+
+
+#endif // DIGRAPHSTATS_HPP
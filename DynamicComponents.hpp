@@ -0,0 +1,610 @@
+// DynamicComponents.hpp
+//
+// This header file declares a class template called DynamicComponents,
+// which keeps track of the strongly connected components of a Digraph
+// as edges are added to it, instead of finding them all over again
+// whenever the question comes up.
+//
+// A DynamicComponents keeps the condensation of the graph (the DAG with
+// one node per component) in topological order, the way Pearce and
+// Kelly's dynamic topological sort does.  An edge that agrees with the
+// order, or that stays inside one component, costs constant expected
+// time.  An edge that points backward sends a search forward from its
+// "to" component and backward from its "from" component, each going no
+// further than the stretch of the order between the two; if the
+// searches meet, every component they both reached lies on a new cycle
+// and they're merged into one, and either way the components they
+// reached are reordered among the positions they already held.
+//
+// The searches walk the condensation, not the graph: each component
+// keeps the other components it has edges to and from, with a count of
+// the edges, so that a big component costs no more to cross than the
+// number of its neighbors.  Merging moves the neighbors of the smaller
+// components into the largest one's, and the vertices keep track of
+// their components with a union-find forest.
+//
+// The neighbor counts also say how many source components (that no
+// other component has an edge into) and sink components (that have no
+// edge out to another) there are.  A graph with more than one
+// component needs at least max(sources, sinks) more edges to become
+// strongly connected, and that many always suffice.
+//
+// Removing an edge can split a component, which this structure has no
+// cheap way to notice, so removals just mark everything as out of date;
+// the next query or insertion finds the components from scratch, in
+// O(V + E) time, and carries on incrementally from there.
+//
+// A DynamicComponents refers to a Digraph that lives elsewhere and must
+// outlive it.  Changes made to the Digraph directly, rather than through
+// the DynamicComponents, aren't seen until rebuild() is called.
+
+#ifndef DYNAMICCOMPONENTS_HPP
+#define DYNAMICCOMPONENTS_HPP
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Digraph.hpp"
+
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator = std::allocator<char>>
+class DynamicComponents
+{
+public:
+    typedef Digraph<VertexInfo, EdgeInfo, Allocator> Graph;
+
+    // The constructor finds the strongly connected components of d.
+    explicit DynamicComponents(Graph& d);
+
+    DynamicComponents(const DynamicComponents&) = delete;
+    DynamicComponents& operator=(const DynamicComponents&) = delete;
+
+    // graph() returns the Digraph whose components are being tracked.
+    const Graph& graph() const noexcept;
+
+    // componentCount() returns the number of strongly connected
+    // components, and isStronglyConnected() returns true if there is
+    // at most one, as Digraph::isStronglyConnected() would.
+    int componentCount() const;
+    bool isStronglyConnected() const;
+
+    // component() returns the vertex number of a representative member
+    // of the given vertex's component, so that two vertices are in the
+    // same component exactly when component() returns the same number
+    // for both.  Which member represents a component can change as the
+    // graph does.  If the vertex does not exist, a DigraphException is
+    // thrown instead.
+    int component(int vertex) const;
+
+    // sourceComponents() and sinkComponents() return the number of
+    // components with no edges in from, and no edges out to, other
+    // components.  edgesToStronglyConnect() returns the fewest edges
+    // that would have to be added to make the graph strongly connected.
+    int sourceComponents() const;
+    int sinkComponents() const;
+    int edgesToStronglyConnect() const;
+
+    // The member functions below change the graph, behaving just like
+    // the Digraph member functions of the same names, and then bring
+    // the components up to date.  If the Digraph throws, nothing
+    // changes.
+    void addVertex(int vertex, const VertexInfo& vinfo);
+    void addEdge(int fromVertex, int toVertex, const EdgeInfo& einfo);
+    void addEdges(const std::vector<DigraphEdge<EdgeInfo>>& batch);
+    void removeVertex(int vertex);
+    void removeEdge(int fromVertex, int toVertex);
+    void removeEdges(const std::vector<std::pair<int, int>>& batch);
+
+    // rebuild() finds the components from scratch.  It's the way to
+    // catch up after the Digraph has been changed directly.
+    void rebuild();
+
+
+private:
+    // A Neighbors maps the components next to one component to the
+    // number of edges between them.
+    typedef std::unordered_map<int, int> Neighbors;
+
+    Graph& d;
+
+    // Everything below describes the components as of the last change,
+    // unless stale is set, in which case the next query or insertion
+    // finds them again.  It's mutable because the queries do that, and
+    // because find() shortens paths in the forest as it goes.
+    //
+    // Vertices are numbered densely in the order they were added since
+    // the last rebuild; index maps vertex numbers to dense indices and
+    // numbers maps them back.  A component is named by the dense index
+    // of its root in the union-find forest kept in parent.  The rest are
+    // only meaningful for roots:
+    //
+    // * order is the component's position in the topological order of
+    //   the condensation
+    // * successors and predecessors are its neighbors along edges out
+    //   of it and into it
+    mutable bool stale;
+    mutable std::unordered_map<int, int> index;
+    mutable std::vector<int> numbers;
+    mutable std::vector<int> parent;
+    mutable std::vector<int> order;
+    mutable std::vector<Neighbors> successors;
+    mutable std::vector<Neighbors> predecessors;
+    mutable int components;
+    mutable int sources;
+    mutable int sinks;
+    mutable int nextOrder;
+
+    // The searches reuse these: forwardMark[c] and backwardMark[c] are
+    // set to stamp when a search reaches component c.  The stamp only
+    // ever goes up, so marks left over from before a rebuild are never
+    // mistaken for new ones.
+    std::vector<int> forwardMark;
+    std::vector<int> backwardMark;
+    int stamp;
+    std::vector<int> forward;
+    std::vector<int> backward;
+    std::vector<int> stack;
+
+    // refresh() rebuilds the components if they're out of date.
+    void refresh() const;
+    void rebuildNow() const;
+
+    // find() returns the root of the component of the vertex with the
+    // given dense index.
+    int find(int i) const;
+
+    // tally() adds (with sign 1) or removes (with sign -1) a component
+    // from the counts of source and sink components.
+    void tally(int c, int sign) const;
+
+    // insert() brings the components up to date after an edge has been
+    // added between the vertices with the given dense indices.
+    void insert(int u, int v);
+
+    // reach() finds the components reachable from start (going forward)
+    // or that can reach it (going backward) without leaving the stretch
+    // of the topological order that ends at bound, marking them with
+    // the current stamp and listing them in found.
+    void reach(int start, bool goForward, int bound, std::vector<int>& mark, std::vector<int>& found);
+
+    // merge() merges the components marked by both searches, which are
+    // listed in cycle, into one and returns its root.
+    int merge(const std::vector<int>& cycle);
+};
+
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DynamicComponents<VertexInfo, EdgeInfo, Allocator>::DynamicComponents(Graph& d)
+    : d(d), stale{true}, components{0}, sources{0}, sinks{0}, nextOrder{0}, stamp{0}
+{
+    rebuildNow();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+const typename DynamicComponents<VertexInfo, EdgeInfo, Allocator>::Graph&
+DynamicComponents<VertexInfo, EdgeInfo, Allocator>::graph() const noexcept
+{
+    return d;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int DynamicComponents<VertexInfo, EdgeInfo, Allocator>::componentCount() const
+{
+    refresh();
+    return components;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+bool DynamicComponents<VertexInfo, EdgeInfo, Allocator>::isStronglyConnected() const
+{
+    return componentCount() <= 1;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int DynamicComponents<VertexInfo, EdgeInfo, Allocator>::component(int vertex) const
+{
+    d.vertexInfoRef(vertex);
+    refresh();
+    return numbers[find(index.find(vertex)->second)];
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int DynamicComponents<VertexInfo, EdgeInfo, Allocator>::sourceComponents() const
+{
+    refresh();
+    return sources;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int DynamicComponents<VertexInfo, EdgeInfo, Allocator>::sinkComponents() const
+{
+    refresh();
+    return sinks;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int DynamicComponents<VertexInfo, EdgeInfo, Allocator>::edgesToStronglyConnect() const
+{
+    refresh();
+    return components <= 1 ? 0 : std::max(sources, sinks);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::addVertex(int vertex, const VertexInfo& vinfo)
+{
+    d.addVertex(vertex, vinfo);
+
+    if (stale)
+    {
+        return;
+    }
+
+    // A new vertex is a component of its own, both a source and a
+    // sink, and can go anywhere in the order; the end is simplest.
+    int i = static_cast<int>(numbers.size());
+
+    index.emplace(vertex, i);
+    numbers.push_back(vertex);
+    parent.push_back(i);
+    order.push_back(nextOrder++);
+    successors.emplace_back();
+    predecessors.emplace_back();
+
+    ++components;
+    tally(i, 1);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::addEdge(int fromVertex, int toVertex, const EdgeInfo& einfo)
+{
+    d.addEdge(fromVertex, toVertex, einfo);
+
+    if (!stale)
+    {
+        insert(index.find(fromVertex)->second, index.find(toVertex)->second);
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::addEdges(const std::vector<DigraphEdge<EdgeInfo>>& batch)
+{
+    d.addEdges(batch);
+
+    if (!stale)
+    {
+        for (const DigraphEdge<EdgeInfo>& e : batch)
+        {
+            insert(index.find(e.fromVertex)->second, index.find(e.toVertex)->second);
+        }
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::removeVertex(int vertex)
+{
+    d.removeVertex(vertex);
+    stale = true;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::removeEdge(int fromVertex, int toVertex)
+{
+    d.removeEdge(fromVertex, toVertex);
+    stale = true;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::removeEdges(const std::vector<std::pair<int, int>>& batch)
+{
+    d.removeEdges(batch);
+    stale = stale || !batch.empty();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::rebuild()
+{
+    rebuildNow();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::refresh() const
+{
+    if (stale)
+    {
+        rebuildNow();
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::rebuildNow() const
+{
+    DigraphComponents found = d.stronglyConnectedComponents();
+    int n = d.vertexCount();
+
+    index.clear();
+    numbers.clear();
+    numbers.reserve(n);
+
+    for (auto const& v : d.allVertices())
+    {
+        index.emplace(v.first, static_cast<int>(numbers.size()));
+        numbers.push_back(v.first);
+    }
+
+    parent.assign(n, 0);
+    order.assign(n, 0);
+    successors.assign(n, Neighbors{});
+    predecessors.assign(n, Neighbors{});
+
+    // Each component is rooted at its first member, and DigraphComponents
+    // already numbers the components in topological order.
+    for (std::size_t c = 0; c < found.members.size(); ++c)
+    {
+        int root = index.find(found.members[c].front())->second;
+        order[root] = static_cast<int>(c);
+
+        for (int vertex : found.members[c])
+        {
+            parent[index.find(vertex)->second] = root;
+        }
+    }
+
+    for (const DigraphEdge<EdgeInfo>& e : d.allEdges())
+    {
+        int from = parent[index.find(e.fromVertex)->second];
+        int to = parent[index.find(e.toVertex)->second];
+
+        if (from != to)
+        {
+            ++successors[from][to];
+            ++predecessors[to][from];
+        }
+    }
+
+    components = static_cast<int>(found.members.size());
+    nextOrder = components;
+    sources = 0;
+    sinks = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        if (parent[i] == i)
+        {
+            tally(i, 1);
+        }
+    }
+
+    stale = false;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int DynamicComponents<VertexInfo, EdgeInfo, Allocator>::find(int i) const
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+
+    return i;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::tally(int c, int sign) const
+{
+    sources += predecessors[c].empty() ? sign : 0;
+    sinks += successors[c].empty() ? sign : 0;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::insert(int u, int v)
+{
+    int x = find(u);
+    int y = find(v);
+
+    if (x == y)
+    {
+        return;
+    }
+
+    tally(x, -1);
+    tally(y, -1);
+    ++successors[x][y];
+    ++predecessors[y][x];
+    tally(x, 1);
+    tally(y, 1);
+
+    if (order[x] < order[y])
+    {
+        return;
+    }
+
+    // The edge points backward, so the stretch of the order from y to
+    // x needs another look.  Anything reachable from y and able to
+    // reach x lies in it, and is now on a cycle through the new edge.
+    if (forwardMark.size() < numbers.size())
+    {
+        forwardMark.resize(numbers.size(), 0);
+        backwardMark.resize(numbers.size(), 0);
+    }
+
+    ++stamp;
+    reach(y, true, order[x], forwardMark, forward);
+    reach(x, false, order[y], backwardMark, backward);
+
+    std::vector<int> positions;
+    positions.reserve(forward.size() + backward.size());
+
+    for (int c : forward)
+    {
+        positions.push_back(order[c]);
+    }
+
+    for (int c : backward)
+    {
+        if (forwardMark[c] != stamp)
+        {
+            positions.push_back(order[c]);
+        }
+    }
+
+    std::sort(positions.begin(), positions.end());
+
+    auto byOrder = [&](int a, int b) { return order[a] < order[b]; };
+    auto inCycle = [&](int c) { return forwardMark[c] == stamp && backwardMark[c] == stamp; };
+
+    // Whatever can reach x goes first and whatever y can reach goes
+    // last, each keeping its old relative order; if there's a cycle,
+    // its merged component goes in between.  None of the components in
+    // between these positions are connected to the merged one, so it
+    // can take any position that keeps the other two groups apart.
+    std::vector<int> cycle;
+
+    for (int c : forward)
+    {
+        if (inCycle(c))
+        {
+            cycle.push_back(c);
+        }
+    }
+
+    backward.erase(std::remove_if(backward.begin(), backward.end(), inCycle), backward.end());
+    forward.erase(std::remove_if(forward.begin(), forward.end(), inCycle), forward.end());
+    std::sort(backward.begin(), backward.end(), byOrder);
+    std::sort(forward.begin(), forward.end(), byOrder);
+
+    std::size_t next = 0;
+
+    for (int c : backward)
+    {
+        order[c] = positions[next++];
+    }
+
+    if (!cycle.empty())
+    {
+        order[merge(cycle)] = positions[next];
+    }
+
+    next = positions.size() - forward.size();
+
+    for (int c : forward)
+    {
+        order[c] = positions[next++];
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicComponents<VertexInfo, EdgeInfo, Allocator>::reach(
+    int start, bool goForward, int bound, std::vector<int>& mark, std::vector<int>& found)
+{
+    found.clear();
+    stack.clear();
+    mark[start] = stamp;
+    found.push_back(start);
+    stack.push_back(start);
+
+    while (!stack.empty())
+    {
+        int c = stack.back();
+        stack.pop_back();
+
+        for (auto const& neighbor : goForward ? successors[c] : predecessors[c])
+        {
+            int next = neighbor.first;
+
+            if (mark[next] != stamp && (goForward ? order[next] <= bound : order[next] >= bound))
+            {
+                mark[next] = stamp;
+                found.push_back(next);
+                stack.push_back(next);
+            }
+        }
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int DynamicComponents<VertexInfo, EdgeInfo, Allocator>::merge(const std::vector<int>& cycle)
+{
+    auto size = [&](int c) { return successors[c].size() + predecessors[c].size(); };
+    int root = *std::max_element(
+        cycle.begin(), cycle.end(), [&](int a, int b) { return size(a) < size(b); });
+
+    auto inCycle = [&](int c) { return forwardMark[c] == stamp && backwardMark[c] == stamp; };
+
+    for (int c : cycle)
+    {
+        tally(c, -1);
+    }
+
+    // The other components' neighbors outside the cycle become the
+    // root's, and those neighbors' entries for them are moved over to
+    // the root to match.  Edges between two of the merging components
+    // stop counting at all.
+    auto moveNeighbors = [&](int c, Neighbors& from, Neighbors& into, std::vector<Neighbors>& reverse)
+    {
+        for (auto const& neighbor : from)
+        {
+            if (inCycle(neighbor.first))
+            {
+                continue;
+            }
+
+            into[neighbor.first] += neighbor.second;
+
+            Neighbors& back = reverse[neighbor.first];
+            back.erase(c);
+            back[root] += neighbor.second;
+        }
+
+        Neighbors{}.swap(from);
+    };
+
+    for (int c : cycle)
+    {
+        if (c != root)
+        {
+            moveNeighbors(c, successors[c], successors[root], predecessors);
+            moveNeighbors(c, predecessors[c], predecessors[root], successors);
+            parent[c] = root;
+        }
+    }
+
+    for (int c : cycle)
+    {
+        successors[root].erase(c);
+        predecessors[root].erase(c);
+    }
+
+    components -= static_cast<int>(cycle.size()) - 1;
+    tally(root, 1);
+
+    return root;
+}
+
+
+
+#endif // DYNAMICCOMPONENTS_HPP
@@ -0,0 +1,617 @@
+// DynamicShortestPaths.hpp
+//
+// This header file declares a class template called DynamicShortestPaths,
+// which keeps the shortest paths from a set of source vertices of a
+// Digraph up to date as the Digraph changes, instead of running
+// findShortestPaths() again after every change.
+//
+// For each source, a DynamicShortestPaths remembers the distance to
+// every vertex the source can reach and the vertex before it on a
+// shortest path; together, those predecessors form a shortest path
+// tree.  Changes to the graph are made through the DynamicShortestPaths,
+// which repairs each tree in the manner of Ramalingam and Reps:
+//
+// * when an edge is added or gets lighter, a Dijkstra search starts
+//   from its "to" vertex and goes only as far as distances improve
+// * when a tree edge is removed or gets heavier, the subtree below it
+//   is cut loose; each vertex in the subtree starts from the best
+//   distance its edges from outside the subtree offer, and a Dijkstra
+//   search among them settles the rest.  Whatever that search doesn't
+//   reach is no longer reachable at all
+// * any other change can't make a shortest path shorter or longer, so
+//   it costs no more than checking that
+//
+// Either way, the work a change takes is proportional to the number of
+// vertices whose shortest paths it changes, and their edges, not to
+// the size of the graph.
+//
+// A DynamicShortestPaths refers to a Digraph that lives elsewhere and
+// must outlive it.  Changes made to the Digraph directly, rather than
+// through the DynamicShortestPaths, aren't seen until rebuild() is
+// called; neither are changes to whatever the weight function reads,
+// unless reweighEdge() is called for each edge they affect.
+
+#ifndef DYNAMICSHORTESTPATHS_HPP
+#define DYNAMICSHORTESTPATHS_HPP
+
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Digraph.hpp"
+#include "DigraphRoute.hpp"
+#include "DigraphStats.hpp"
+
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator = std::allocator<char>>
+class DynamicShortestPaths
+{
+public:
+    typedef Digraph<VertexInfo, EdgeInfo, Allocator> Graph;
+
+    // The constructor finds the shortest paths in d from each of the
+    // given sources, using the given weight function the way
+    // findShortestPaths() would.  Edge weights must not be negative.
+    // If any of the sources does not exist, a DigraphException is
+    // thrown instead.
+    DynamicShortestPaths(
+        Graph& d, const std::vector<int>& sources,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc);
+
+    DynamicShortestPaths(const DynamicShortestPaths&) = delete;
+    DynamicShortestPaths& operator=(const DynamicShortestPaths&) = delete;
+
+    // graph() returns the Digraph whose shortest paths are being kept.
+    const Graph& graph() const noexcept;
+
+    // sources() returns the vertex numbers of the sources, in ascending
+    // order.
+    std::vector<int> sources() const;
+
+    // addSource() starts keeping the shortest paths from another
+    // source, which costs one full search, and removeSource() stops
+    // keeping them.  addSource() throws a DigraphException if the
+    // vertex does not exist, and does nothing if it's already a source.
+    void addSource(int source);
+    void removeSource(int source);
+
+    // distance() returns the length of the shortest path from the given
+    // source to the given vertex, or infinity if there isn't one, and
+    // predecessor() returns the vertex before it on that path, or the
+    // vertex itself if it's the source or can't be reached.  Both throw
+    // a DigraphException if the source isn't one, or if the vertex does
+    // not exist.
+    double distance(int source, int vertex) const;
+    int predecessor(int source, int vertex) const;
+
+    // findShortestPaths() returns the predecessors and, if given a
+    // std::map to fill in, the distances from the given source in the
+    // same form as Digraph::findShortestPaths() does, without searching
+    // anything.  It throws a DigraphException if the source isn't one.
+    std::map<int, int> findShortestPaths(int source) const;
+    std::map<int, int> findShortestPaths(int source, std::map<int, double>& distances) const;
+
+    // The member functions below change the graph, behaving just like
+    // the Digraph member functions of the same names, and then repair
+    // the shortest paths from every source.  If the Digraph throws, the
+    // graph and the paths are left as they were.  removeVertex() also
+    // throws a DigraphException, leaving everything unchanged, if the
+    // vertex is one of the sources.
+    void addVertex(int vertex, const VertexInfo& vinfo);
+    void addEdge(int fromVertex, int toVertex, const EdgeInfo& einfo);
+    void removeVertex(int vertex);
+    void removeEdge(int fromVertex, int toVertex);
+    void setEdgeInfo(int fromVertex, int toVertex, const EdgeInfo& einfo);
+
+    // reweighEdge() repairs the shortest paths after the weight the
+    // weight function gives the edge with the given "from" and "to"
+    // vertex numbers has changed, even though its EdgeInfo hasn't (say,
+    // because the weight function looks the edge's weight up in a
+    // table that's been updated).  If either of those vertices does not
+    // exist *or* if the edge does not exist, a DigraphException is
+    // thrown instead.
+    void reweighEdge(int fromVertex, int toVertex);
+
+    // rebuild() throws away what's known and searches again from every
+    // source.  It's the way to catch up after the Digraph has been
+    // changed directly, or after the weight function has thrown in the
+    // middle of a repair.
+    void rebuild();
+
+
+private:
+    // A Label is what a tree knows about a vertex the source can reach.
+    // While a repair is cutting loose a subtree, the vertices in it are
+    // marked by having an infinite distance.
+    struct Label
+    {
+        double distance;
+        int predecessor;
+    };
+
+    typedef std::unordered_map<int, Label> Labels;
+
+    Graph& d;
+    std::function<double(const EdgeInfo&)> weight;
+    std::map<int, Labels> trees;
+
+    // The repairs reuse these between changes: queue holds the vertices
+    // waiting to be settled and stack holds the subtree being cut loose.
+    DigraphRouteQueue queue;
+    std::vector<int> stack;
+
+    // treeOf() returns the tree of the given source, throwing a
+    // DigraphException if it isn't one.
+    const Labels& treeOf(int source) const;
+
+    // search() finds the whole tree of the given source from scratch.
+    void search(int source, Labels& labels);
+
+    // improve() offers to with a path of the given length through from,
+    // and if that's shorter than the one it has, spreads the news.
+    void improve(Labels& labels, int fromVertex, int toVertex, double distance);
+
+    // reweigh() repairs labels after the edge from fromVertex to
+    // toVertex, which is still in the graph, has changed weight.
+    void reweigh(Labels& labels, int source, int fromVertex, int toVertex);
+
+    // cut() marks the subtree below (and including) the given vertex,
+    // appending its vertices to affected, and settle() finds new
+    // shortest paths for the marked vertices once the graph has
+    // changed, forgetting the ones nothing reaches any more.
+    void cut(Labels& labels, int vertex, std::vector<int>& affected);
+    void settle(Labels& labels, const std::vector<int>& affected);
+
+    // propagate() runs Dijkstra's algorithm from whatever is in the
+    // queue until it's empty.
+    void propagate(Labels& labels);
+};
+
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::DynamicShortestPaths(
+    Graph& d, const std::vector<int>& sources,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc)
+    : d(d), weight{std::move(edgeWeightFunc)}
+{
+    for (int source : sources)
+    {
+        addSource(source);
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+const typename DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::Graph&
+DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::graph() const noexcept
+{
+    return d;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::vector<int> DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::sources() const
+{
+    std::vector<int> result;
+    result.reserve(trees.size());
+
+    for (auto const& tree : trees)
+    {
+        result.push_back(tree.first);
+    }
+
+    return result;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::addSource(int source)
+{
+    d.vertexInfoRef(source);
+
+    if (trees.find(source) == trees.end())
+    {
+        search(source, trees[source]);
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::removeSource(int source)
+{
+    trees.erase(source);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+double DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::distance(int source, int vertex) const
+{
+    const Labels& labels = treeOf(source);
+    auto found = labels.find(vertex);
+
+    if (found != labels.end())
+    {
+        return found->second.distance;
+    }
+
+    d.vertexInfoRef(vertex);
+    return std::numeric_limits<double>::infinity();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+int DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::predecessor(int source, int vertex) const
+{
+    const Labels& labels = treeOf(source);
+    auto found = labels.find(vertex);
+
+    if (found != labels.end())
+    {
+        return found->second.predecessor;
+    }
+
+    d.vertexInfoRef(vertex);
+    return vertex;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::map<int, int> DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::findShortestPaths(int source) const
+{
+    std::map<int, double> distances;
+    return findShortestPaths(source, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+std::map<int, int> DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::findShortestPaths(
+    int source, std::map<int, double>& distances) const
+{
+    const Labels& labels = treeOf(source);
+    std::map<int, int> predecessors;
+
+    distances.clear();
+
+    for (auto const& v : d.allVertices())
+    {
+        auto found = labels.find(v.first);
+
+        if (found != labels.end())
+        {
+            distances.emplace_hint(distances.end(), v.first, found->second.distance);
+            predecessors.emplace_hint(predecessors.end(), v.first, found->second.predecessor);
+        }
+        else
+        {
+            distances.emplace_hint(distances.end(), v.first, std::numeric_limits<double>::infinity());
+            predecessors.emplace_hint(predecessors.end(), v.first, v.first);
+        }
+    }
+
+    return predecessors;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::addVertex(int vertex, const VertexInfo& vinfo)
+{
+    // A new vertex has no edges, so no source can reach it yet.
+    d.addVertex(vertex, vinfo);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::addEdge(int fromVertex, int toVertex, const EdgeInfo& einfo)
+{
+    d.addEdge(fromVertex, toVertex, einfo);
+
+    double w = weight(d.edgeInfoRef(fromVertex, toVertex));
+
+    for (auto& tree : trees)
+    {
+        auto from = tree.second.find(fromVertex);
+
+        if (from != tree.second.end())
+        {
+            improve(tree.second, fromVertex, toVertex, from->second.distance + w);
+        }
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::removeVertex(int vertex)
+{
+    d.vertexInfoRef(vertex);
+
+    if (trees.find(vertex) != trees.end())
+    {
+        throw DigraphException("Vertex " + std::to_string(vertex) + " is a source");
+    }
+
+    // The subtrees have to be found while the vertex's edges are still
+    // there to follow.
+    std::vector<std::vector<int>> affected(trees.size());
+    int t = 0;
+
+    for (auto& tree : trees)
+    {
+        if (tree.second.find(vertex) != tree.second.end())
+        {
+            cut(tree.second, vertex, affected[t]);
+        }
+
+        ++t;
+    }
+
+    d.removeVertex(vertex);
+    t = 0;
+
+    for (auto& tree : trees)
+    {
+        if (!affected[t].empty())
+        {
+            tree.second.erase(vertex);
+            affected[t].erase(affected[t].begin());
+            settle(tree.second, affected[t]);
+        }
+
+        ++t;
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::removeEdge(int fromVertex, int toVertex)
+{
+    d.removeEdge(fromVertex, toVertex);
+
+    std::vector<int> affected;
+
+    for (auto& tree : trees)
+    {
+        auto to = tree.second.find(toVertex);
+
+        if (to != tree.second.end() && to->second.predecessor == fromVertex && toVertex != tree.first)
+        {
+            affected.clear();
+            cut(tree.second, toVertex, affected);
+            settle(tree.second, affected);
+        }
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::setEdgeInfo(int fromVertex, int toVertex, const EdgeInfo& einfo)
+{
+    d.setEdgeInfo(fromVertex, toVertex, einfo);
+
+    for (auto& tree : trees)
+    {
+        reweigh(tree.second, tree.first, fromVertex, toVertex);
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::reweighEdge(int fromVertex, int toVertex)
+{
+    d.edgeInfoRef(fromVertex, toVertex);
+
+    for (auto& tree : trees)
+    {
+        reweigh(tree.second, tree.first, fromVertex, toVertex);
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::rebuild()
+{
+    for (auto& tree : trees)
+    {
+        search(tree.first, tree.second);
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+const typename DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::Labels&
+DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::treeOf(int source) const
+{
+    auto tree = trees.find(source);
+
+    if (tree == trees.end())
+    {
+        throw DigraphException("Vertex " + std::to_string(source) + " is not a source");
+    }
+
+    return tree->second;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::search(int source, Labels& labels)
+{
+    labels.clear();
+    labels[source] = Label{0.0, source};
+    queue = DigraphRouteQueue{};
+    queue.emplace(0.0, source);
+    propagate(labels);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::improve(
+    Labels& labels, int fromVertex, int toVertex, double distance)
+{
+    auto to = labels.find(toVertex);
+
+    if (to == labels.end() || distance < to->second.distance)
+    {
+        labels[toVertex] = Label{distance, fromVertex};
+        queue.emplace(distance, toVertex);
+        propagate(labels);
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::reweigh(
+    Labels& labels, int source, int fromVertex, int toVertex)
+{
+    auto from = labels.find(fromVertex);
+
+    if (from == labels.end())
+    {
+        return;
+    }
+
+    double distance = from->second.distance + weight(d.edgeInfoRef(fromVertex, toVertex));
+    auto to = labels.find(toVertex);
+
+    // Only a tree edge getting heavier can make anything longer; the
+    // distances along it were worked out with the same arithmetic, so
+    // an unchanged weight compares equal.
+    if (to != labels.end() && to->second.predecessor == fromVertex && toVertex != source
+        && distance > to->second.distance)
+    {
+        std::vector<int> affected;
+        cut(labels, toVertex, affected);
+        settle(labels, affected);
+    }
+    else
+    {
+        improve(labels, fromVertex, toVertex, distance);
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::cut(
+    Labels& labels, int vertex, std::vector<int>& affected)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    labels[vertex] = Label{infinity, -1};
+    affected.push_back(vertex);
+    stack.clear();
+    stack.push_back(vertex);
+
+    // A vertex's children in the tree are the vertices its edges lead
+    // to that still name it as their predecessor.
+    while (!stack.empty())
+    {
+        int u = stack.back();
+        stack.pop_back();
+
+        for (const DigraphEdge<EdgeInfo>& e : d.outEdges(u))
+        {
+            auto child = labels.find(e.toVertex);
+
+            if (child != labels.end() && child->second.predecessor == u && e.toVertex != u)
+            {
+                child->second = Label{infinity, -1};
+                affected.push_back(e.toVertex);
+                stack.push_back(e.toVertex);
+            }
+        }
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::settle(
+    Labels& labels, const std::vector<int>& affected)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    // Every vertex in the subtree starts out with the best path it can
+    // get through a vertex outside it, whose distance is still right.
+    for (int v : affected)
+    {
+        Label& label = labels[v];
+
+        for (int u : d.inVertices(v))
+        {
+            auto from = labels.find(u);
+
+            if (from != labels.end() && from->second.distance < infinity)
+            {
+                double distance = from->second.distance + weight(d.edgeInfoRef(u, v));
+
+                if (distance < label.distance)
+                {
+                    label = Label{distance, u};
+                }
+            }
+        }
+
+        if (label.distance < infinity)
+        {
+            queue.emplace(label.distance, v);
+        }
+    }
+
+    propagate(labels);
+
+    for (int v : affected)
+    {
+        auto found = labels.find(v);
+
+        if (found->second.distance == infinity)
+        {
+            labels.erase(found);
+        }
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo, typename Allocator>
+void DynamicShortestPaths<VertexInfo, EdgeInfo, Allocator>::propagate(Labels& labels)
+{
+    DIGRAPH_STATS_PHASE(searchSeconds);
+
+    while (!queue.empty())
+    {
+        std::pair<double, int> next = queue.top();
+        queue.pop();
+
+        DIGRAPH_STATS_ADD(heapPops, 1);
+
+        // A vertex can be queued more than once on its way down; only
+        // its latest (shortest) entry counts.
+        if (next.first > labels.find(next.second)->second.distance)
+        {
+            continue;
+        }
+
+        DIGRAPH_STATS_ADD(verticesSettled, 1);
+
+        for (const DigraphEdge<EdgeInfo>& e : d.outEdges(next.second))
+        {
+            double distance = next.first + weight(e.einfo);
+            auto to = labels.find(e.toVertex);
+
+            DIGRAPH_STATS_ADD(edgesRelaxed, 1);
+
+            if (to == labels.end() || distance < to->second.distance)
+            {
+                labels[e.toVertex] = Label{distance, next.second};
+                queue.emplace(distance, e.toVertex);
+
+                DIGRAPH_STATS_ADD(heapPushes, 1);
+            }
+        }
+    }
+}
+
+
+
+#endif // DYNAMICSHORTESTPATHS_HPP
@@ -0,0 +1,236 @@
+// EdgeIndex.hpp
+//
+// This header file declares a class template called EdgeIndex, which is
+// a hash table keyed on the ("from" vertex, "to" vertex) pair of an
+// edge.  Digraph uses one to find any edge in constant expected time,
+// instead of scanning the adjacency list of the vertex it leaves.
+//
+// The table uses open addressing with linear probing, so a lookup
+// usually touches a single cache line.  Removal shifts later entries of
+// a probe run backward instead of leaving tombstones, so a table that
+// sees a lot of churn doesn't slowly fill up with dead slots.
+
+#ifndef EDGEINDEX_HPP
+#define EDGEINDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DigraphStats.hpp"
+
+
+
+template <typename Value>
+class EdgeIndex
+{
+public:
+    // The constructor initializes an empty EdgeIndex.
+    EdgeIndex();
+
+    // size() returns the number of edges in the index.
+    int size() const noexcept;
+
+    // clear() removes every edge from the index.
+    void clear();
+
+    // reserve() makes room for at least the given number of edges, so
+    // that inserting that many won't have to rehash.
+    void reserve(int edges);
+
+    // find() returns a pointer to the value stored for the given edge,
+    // or nullptr if the edge isn't in the index.
+    Value* find(int fromVertex, int toVertex);
+    const Value* find(int fromVertex, int toVertex) const;
+
+    // insert() stores the given value for the given edge and returns
+    // true, unless the edge was already in the index, in which case
+    // nothing changes and it returns false.
+    bool insert(int fromVertex, int toVertex, const Value& value);
+
+    // erase() removes the given edge and returns true, or returns false
+    // if the edge wasn't in the index.
+    bool erase(int fromVertex, int toVertex);
+
+
+private:
+    struct Slot
+    {
+        int fromVertex;
+        int toVertex;
+        Value value;
+        bool used;
+    };
+
+    std::vector<Slot> slots;
+    std::size_t mask;
+    int count;
+
+    std::size_t home(int fromVertex, int toVertex) const noexcept;
+    std::size_t locate(int fromVertex, int toVertex) const noexcept;
+    void rehash(std::size_t capacity);
+};
+
+
+
+template <typename Value>
+EdgeIndex<Value>::EdgeIndex()
+    : slots(16), mask{15}, count{0}
+{
+}
+
+
+template <typename Value>
+int EdgeIndex<Value>::size() const noexcept
+{
+    return count;
+}
+
+
+template <typename Value>
+void EdgeIndex<Value>::clear()
+{
+    slots.assign(16, Slot());
+    mask = 15;
+    count = 0;
+}
+
+
+template <typename Value>
+void EdgeIndex<Value>::reserve(int edges)
+{
+    std::size_t capacity = slots.size();
+
+    // The table is kept at most half full.
+    while (capacity < 2 * static_cast<std::size_t>(edges))
+    {
+        capacity *= 2;
+    }
+
+    if (capacity != slots.size())
+    {
+        rehash(capacity);
+    }
+}
+
+
+template <typename Value>
+Value* EdgeIndex<Value>::find(int fromVertex, int toVertex)
+{
+    std::size_t i = locate(fromVertex, toVertex);
+    return slots[i].used ? &slots[i].value : nullptr;
+}
+
+
+template <typename Value>
+const Value* EdgeIndex<Value>::find(int fromVertex, int toVertex) const
+{
+    std::size_t i = locate(fromVertex, toVertex);
+    return slots[i].used ? &slots[i].value : nullptr;
+}
+
+
+template <typename Value>
+bool EdgeIndex<Value>::insert(int fromVertex, int toVertex, const Value& value)
+{
+    if (2 * static_cast<std::size_t>(count + 1) > slots.size())
+    {
+        rehash(2 * slots.size());
+    }
+
+    std::size_t i = locate(fromVertex, toVertex);
+
+    if (slots[i].used)
+    {
+        return false;
+    }
+
+    slots[i] = Slot{fromVertex, toVertex, value, true};
+    ++count;
+    return true;
+}
+
+
+template <typename Value>
+bool EdgeIndex<Value>::erase(int fromVertex, int toVertex)
+{
+    std::size_t hole = locate(fromVertex, toVertex);
+
+    if (!slots[hole].used)
+    {
+        return false;
+    }
+
+    // Walk the rest of the probe run, moving back any entry whose home
+    // slot would no longer be reachable across the hole.
+    for (std::size_t i = (hole + 1) & mask; slots[i].used; i = (i + 1) & mask)
+    {
+        std::size_t h = home(slots[i].fromVertex, slots[i].toVertex);
+
+        if (((i - h) & mask) >= ((i - hole) & mask))
+        {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+
+    slots[hole] = Slot();
+    --count;
+    return true;
+}
+
+
+template <typename Value>
+std::size_t EdgeIndex<Value>::home(int fromVertex, int toVertex) const noexcept
+{
+    std::uint64_t key =
+        (static_cast<std::uint64_t>(static_cast<std::uint32_t>(fromVertex)) << 32)
+        | static_cast<std::uint32_t>(toVertex);
+
+    // This is the finalizer from the SplitMix64 generator, which spreads
+    // nearby keys (like consecutive vertex numbers) all over the table.
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+
+    return static_cast<std::size_t>(key) & mask;
+}
+
+
+template <typename Value>
+std::size_t EdgeIndex<Value>::locate(int fromVertex, int toVertex) const noexcept
+{
+    std::size_t i = home(fromVertex, toVertex);
+    DIGRAPH_STATS_ADD(hashProbes, 1);
+
+    while (slots[i].used
+           && (slots[i].fromVertex != fromVertex || slots[i].toVertex != toVertex))
+    {
+        i = (i + 1) & mask;
+        DIGRAPH_STATS_ADD(hashProbes, 1);
+    }
+
+    return i;
+}
+
+
+template <typename Value>
+void EdgeIndex<Value>::rehash(std::size_t capacity)
+{
+    std::vector<Slot> old(capacity);
+    old.swap(slots);
+    mask = capacity - 1;
+
+    for (Slot& slot : old)
+    {
+        if (slot.used)
+        {
+            slots[locate(slot.fromVertex, slot.toVertex)] = slot;
+        }
+    }
+}
+
+
+
+#endif // EDGEINDEX_HPP
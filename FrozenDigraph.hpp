@@ -0,0 +1,703 @@
+// FrozenDigraph.hpp
+//
+// This header file declares a class template called FrozenDigraph,
+// which is a read-only snapshot of a Digraph.  Where a Digraph keeps
+// a std::map of vertices, each with a std::list of outgoing edges, a
+// FrozenDigraph packs the same graph into compressed sparse row (CSR)
+// arrays: the topology lives in a DigraphCsr, the VertexInfo objects
+// in one std::vector parallel to its vertices, and the EdgeInfo
+// objects in one std::vector parallel to its edges.
+//
+// A graph that is built once and then queried many times should be
+// frozen after it's built; the queries are the same ones Digraph
+// offers, but they walk contiguous arrays instead of chasing pointers.
+//
+// A FrozenDigraph can also be saved to a file and loaded back (see
+// DigraphFile.hpp).  A loaded FrozenDigraph doesn't copy anything out
+// of the file: it maps the file into memory and answers its queries
+// straight from the mapped arrays, so loading costs no more than one
+// pass over the topology to check that it's intact.
+
+#ifndef FROZENDIGRAPH_HPP
+#define FROZENDIGRAPH_HPP
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Digraph.hpp"
+#include "DigraphBfs.hpp"
+#include "DigraphCsr.hpp"
+#include "DigraphDeltaStepping.hpp"
+#include "DigraphFile.hpp"
+#include "DigraphShortestPaths.hpp"
+#include "MappedFile.hpp"
+
+
+
+template <typename VertexInfo, typename EdgeInfo>
+class FrozenDigraph
+{
+public:
+    // The default constructor initializes an empty FrozenDigraph, with
+    // no vertices and no edges.
+    FrozenDigraph();
+
+    // This constructor initializes a FrozenDigraph to be a snapshot of
+    // the given Digraph.  Later changes to the Digraph do not affect
+    // the snapshot.
+    template <typename Allocator>
+    explicit FrozenDigraph(const Digraph<VertexInfo, EdgeInfo, Allocator>& d);
+
+    // Copies of a loaded FrozenDigraph share its mapped file.
+    FrozenDigraph(const FrozenDigraph& f);
+    FrozenDigraph(FrozenDigraph&& f) noexcept;
+    FrozenDigraph& operator=(const FrozenDigraph& f);
+    FrozenDigraph& operator=(FrozenDigraph&& f) noexcept;
+
+    // save() writes the snapshot to the file with the given path, and
+    // load() returns a FrozenDigraph backed by the file with the given
+    // path, which must stay in place (and unchanged) for as long as the
+    // FrozenDigraph and its copies are in use.  Both throw a
+    // DigraphException if the file can't be written or read, and load()
+    // throws one if the file is damaged (see readDigraphFile()).  Only
+    // graphs with trivially copyable VertexInfo and EdgeInfo can be
+    // saved and loaded.
+    void save(const std::string& path) const;
+    static FrozenDigraph load(const std::string& path);
+
+    // The member functions below behave just like the Digraph member
+    // functions of the same names, including the DigraphExceptions
+    // they throw and the order in which they list edges.
+    std::vector<int> vertices() const;
+    std::vector<std::pair<int, int>> edges() const;
+    std::vector<std::pair<int, int>> edges(int vertex) const;
+    VertexInfo vertexInfo(int vertex) const;
+    EdgeInfo edgeInfo(int fromVertex, int toVertex) const;
+    int vertexCount() const noexcept;
+    int edgeCount() const noexcept;
+    int edgeCount(int vertex) const;
+    bool isStronglyConnected() const;
+    DigraphComponents stronglyConnectedComponents() const;
+    DigraphBfsTree breadthFirstSearch(int startVertex, unsigned threads = 0) const;
+
+    template <typename PreVisit, typename PostVisit>
+    void depthFirstSearch(int startVertex, PreVisit&& preVisit, PostVisit&& postVisit) const;
+
+    template <typename PreVisit, typename PostVisit>
+    void depthFirstTraversal(PreVisit&& preVisit, PostVisit&& postVisit) const;
+
+    std::map<int, int> findShortestPaths(
+        int startVertex,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc) const;
+
+    std::map<int, int> findShortestPaths(
+        int startVertex,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc,
+        std::map<int, double>& distances) const;
+
+    template <typename WeightFn, typename = DigraphWeightFunction<WeightFn>>
+    std::map<int, int> findShortestPaths(int startVertex, WeightFn&& edgeWeightFunc) const;
+
+    template <typename WeightFn, typename = DigraphWeightFunction<WeightFn>>
+    std::map<int, int> findShortestPaths(
+        int startVertex, WeightFn&& edgeWeightFunc,
+        std::map<int, double>& distances) const;
+
+    DigraphPathMatrix findShortestPathsMany(
+        const std::vector<int>& startVertices,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc,
+        unsigned threads = 0) const;
+
+    std::map<int, int> findShortestPathsParallel(
+        int startVertex,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc,
+        double delta = 0.0, unsigned threads = 0) const;
+
+    std::map<int, int> findShortestPathsParallel(
+        int startVertex,
+        std::function<double(const EdgeInfo&)> edgeWeightFunc,
+        std::map<int, double>& distances,
+        double delta = 0.0, unsigned threads = 0) const;
+
+    // edgeWeights() runs the given weight function over every edge
+    // once and returns the results.  The overloads below that take
+    // them instead of a weight function skip calling it altogether,
+    // reading each weight from one contiguous array instead.  They
+    // throw a DigraphException if the weights don't have exactly one
+    // entry per edge of this FrozenDigraph.
+    template <typename WeightFn>
+    DigraphEdgeWeights edgeWeights(WeightFn&& edgeWeightFunc) const;
+
+    std::map<int, int> findShortestPaths(int startVertex, const DigraphEdgeWeights& weights) const;
+
+    std::map<int, int> findShortestPaths(
+        int startVertex, const DigraphEdgeWeights& weights,
+        std::map<int, double>& distances) const;
+
+    DigraphPathMatrix findShortestPathsMany(
+        const std::vector<int>& startVertices,
+        const DigraphEdgeWeights& weights,
+        unsigned threads = 0) const;
+
+    std::map<int, int> findShortestPathsParallel(
+        int startVertex, const DigraphEdgeWeights& weights,
+        double delta = 0.0, unsigned threads = 0) const;
+
+    std::map<int, int> findShortestPathsParallel(
+        int startVertex, const DigraphEdgeWeights& weights,
+        std::map<int, double>& distances,
+        double delta = 0.0, unsigned threads = 0) const;
+
+    // csr() returns the underlying CSR topology; the edge with index e
+    // in csr().targets carries the EdgeInfo edgeInfoAt(e).
+    DigraphCsrView csr() const noexcept;
+    const EdgeInfo& edgeInfoAt(int edge) const;
+
+
+private:
+    // The arrays the queries use are reached through topology, vinfoData
+    // and einfoData, which point either at the three members after them
+    // or, for a loaded FrozenDigraph, into the mapped file.
+    DigraphCsrView topology;
+    const VertexInfo* vinfoData;
+    const EdgeInfo* einfoData;
+
+    DigraphCsr storage;
+    std::vector<VertexInfo> vinfos;
+    std::vector<EdgeInfo> einfos;
+    std::shared_ptr<MappedFile> mapping;
+
+    // pointAtStorage() points the views at this FrozenDigraph's own
+    // arrays, unless it is backed by a mapped file.
+    void pointAtStorage() noexcept;
+
+    // shortestPaths() is what every overload of findShortestPaths()
+    // runs; weightAt(e) returns the weight of the edge with index e.
+    template <typename WeightAt>
+    std::map<int, int> shortestPaths(
+        int startVertex, const WeightAt& weightAt,
+        std::map<int, double>& distances) const;
+
+    int indexOf(int vertex) const;
+    int edgeIndexOf(int from, int to) const;
+
+    // checkWeights() throws a DigraphException unless the given weights
+    // have one entry per edge.
+    void checkWeights(const DigraphEdgeWeights& weights) const;
+};
+
+
+
+template <typename VertexInfo, typename EdgeInfo>
+FrozenDigraph<VertexInfo, EdgeInfo>::FrozenDigraph()
+{
+    storage.offsets.push_back(0);
+    pointAtStorage();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename Allocator>
+FrozenDigraph<VertexInfo, EdgeInfo>::FrozenDigraph(const Digraph<VertexInfo, EdgeInfo, Allocator>& d)
+{
+    std::vector<const EdgeInfo*> einfoRefs;
+    d.buildCsr(storage, &einfoRefs);
+
+    einfos.reserve(einfoRefs.size());
+
+    for (const EdgeInfo* einfo : einfoRefs)
+    {
+        einfos.push_back(*einfo);
+    }
+
+    vinfos.reserve(storage.numbers.size());
+
+    for (int vertex : storage.numbers)
+    {
+        vinfos.push_back(d.vertexInfoRef(vertex));
+    }
+
+    pointAtStorage();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+FrozenDigraph<VertexInfo, EdgeInfo>::FrozenDigraph(const FrozenDigraph& f)
+    : topology(f.topology), vinfoData{f.vinfoData}, einfoData{f.einfoData},
+      storage(f.storage), vinfos(f.vinfos), einfos(f.einfos), mapping{f.mapping}
+{
+    pointAtStorage();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+FrozenDigraph<VertexInfo, EdgeInfo>::FrozenDigraph(FrozenDigraph&& f) noexcept
+    : topology(f.topology), vinfoData{f.vinfoData}, einfoData{f.einfoData},
+      storage(std::move(f.storage)), vinfos(std::move(f.vinfos)),
+      einfos(std::move(f.einfos)), mapping{std::move(f.mapping)}
+{
+    pointAtStorage();
+    f.pointAtStorage();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+FrozenDigraph<VertexInfo, EdgeInfo>& FrozenDigraph<VertexInfo, EdgeInfo>::operator=(const FrozenDigraph& f)
+{
+    if (this != &f)
+    {
+        storage = f.storage;
+        vinfos = f.vinfos;
+        einfos = f.einfos;
+        mapping = f.mapping;
+        topology = f.topology;
+        vinfoData = f.vinfoData;
+        einfoData = f.einfoData;
+        pointAtStorage();
+    }
+
+    return *this;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+FrozenDigraph<VertexInfo, EdgeInfo>& FrozenDigraph<VertexInfo, EdgeInfo>::operator=(FrozenDigraph&& f) noexcept
+{
+    std::swap(storage, f.storage);
+    std::swap(vinfos, f.vinfos);
+    std::swap(einfos, f.einfos);
+    std::swap(mapping, f.mapping);
+    std::swap(topology, f.topology);
+    std::swap(vinfoData, f.vinfoData);
+    std::swap(einfoData, f.einfoData);
+    pointAtStorage();
+    f.pointAtStorage();
+    return *this;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+void FrozenDigraph<VertexInfo, EdgeInfo>::save(const std::string& path) const
+{
+    bool written = writeDigraphFile<VertexInfo, EdgeInfo>(
+        path, topology,
+        [&](int i) -> const VertexInfo& { return vinfoData[i]; },
+        [&](int e) -> const EdgeInfo& { return einfoData[e]; });
+
+    if (!written)
+    {
+        throw DigraphException("Could not write " + path);
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+FrozenDigraph<VertexInfo, EdgeInfo> FrozenDigraph<VertexInfo, EdgeInfo>::load(const std::string& path)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+
+    if (!file->open(path))
+    {
+        throw DigraphException("Could not read " + path);
+    }
+
+    FrozenDigraph f;
+    const char* problem = readDigraphFile(*file, f.topology, f.vinfoData, f.einfoData);
+
+    if (problem != nullptr)
+    {
+        throw DigraphException(path + ": " + problem);
+    }
+
+    f.mapping = std::move(file);
+    return f;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::vector<int> FrozenDigraph<VertexInfo, EdgeInfo>::vertices() const
+{
+    return std::vector<int>(topology.numbers, topology.numbers + topology.vertexCount());
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::vector<std::pair<int, int>> FrozenDigraph<VertexInfo, EdgeInfo>::edges() const
+{
+    std::vector<std::pair<int, int>> e_list;
+    e_list.reserve(topology.edgeCount());
+
+    for (int u = 0; u < topology.vertexCount(); ++u)
+    {
+        for (int e = topology.offsets[u]; e < topology.offsets[u + 1]; ++e)
+        {
+            e_list.emplace_back(topology.numbers[u], topology.numbers[topology.targets[e]]);
+        }
+    }
+
+    return e_list;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::vector<std::pair<int, int>> FrozenDigraph<VertexInfo, EdgeInfo>::edges(int vertex) const
+{
+    int u = indexOf(vertex);
+    std::vector<std::pair<int, int>> e_list;
+    e_list.reserve(topology.offsets[u + 1] - topology.offsets[u]);
+
+    for (int e = topology.offsets[u]; e < topology.offsets[u + 1]; ++e)
+    {
+        e_list.emplace_back(vertex, topology.numbers[topology.targets[e]]);
+    }
+
+    return e_list;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+VertexInfo FrozenDigraph<VertexInfo, EdgeInfo>::vertexInfo(int vertex) const
+{
+    return vinfoData[indexOf(vertex)];
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+EdgeInfo FrozenDigraph<VertexInfo, EdgeInfo>::edgeInfo(int fromVertex, int toVertex) const
+{
+    return einfoData[edgeIndexOf(fromVertex, toVertex)];
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+int FrozenDigraph<VertexInfo, EdgeInfo>::vertexCount() const noexcept
+{
+    return topology.vertexCount();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+int FrozenDigraph<VertexInfo, EdgeInfo>::edgeCount() const noexcept
+{
+    return topology.edgeCount();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+int FrozenDigraph<VertexInfo, EdgeInfo>::edgeCount(int vertex) const
+{
+    int u = indexOf(vertex);
+    return topology.offsets[u + 1] - topology.offsets[u];
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+bool FrozenDigraph<VertexInfo, EdgeInfo>::isStronglyConnected() const
+{
+    return csrIsStronglyConnected(topology);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+DigraphComponents FrozenDigraph<VertexInfo, EdgeInfo>::stronglyConnectedComponents() const
+{
+    return csrComponents(topology);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+DigraphBfsTree FrozenDigraph<VertexInfo, EdgeInfo>::breadthFirstSearch(int startVertex, unsigned threads) const
+{
+    return csrBfsTree(topology, indexOf(startVertex), threads);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename PreVisit, typename PostVisit>
+void FrozenDigraph<VertexInfo, EdgeInfo>::depthFirstSearch(
+    int startVertex, PreVisit&& preVisit, PostVisit&& postVisit) const
+{
+    int start = indexOf(startVertex);
+
+    std::vector<bool> visited(topology.vertexCount());
+    std::vector<std::pair<int, int>> stack;
+
+    csrDepthFirstSearch(
+        topology, start, visited, stack,
+        [&](int i) { preVisit(topology.numbers[i]); },
+        [&](int i) { postVisit(topology.numbers[i]); });
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename PreVisit, typename PostVisit>
+void FrozenDigraph<VertexInfo, EdgeInfo>::depthFirstTraversal(
+    PreVisit&& preVisit, PostVisit&& postVisit) const
+{
+    std::vector<bool> visited(topology.vertexCount());
+    std::vector<std::pair<int, int>> stack;
+
+    for (int i = 0; i < topology.vertexCount(); ++i)
+    {
+        csrDepthFirstSearch(
+            topology, i, visited, stack,
+            [&](int j) { preVisit(topology.numbers[j]); },
+            [&](int j) { postVisit(topology.numbers[j]); });
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPaths(
+    int startVertex,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc) const
+{
+    std::map<int, double> distances;
+    return findShortestPaths(startVertex, edgeWeightFunc, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPaths(
+    int startVertex,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc,
+    std::map<int, double>& distances) const
+{
+    return shortestPaths(
+        startVertex, [&](int e) { return edgeWeightFunc(einfoData[e]); }, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename WeightFn, typename>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPaths(
+    int startVertex, WeightFn&& edgeWeightFunc) const
+{
+    std::map<int, double> distances;
+    return findShortestPaths(startVertex, edgeWeightFunc, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename WeightFn, typename>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPaths(
+    int startVertex, WeightFn&& edgeWeightFunc,
+    std::map<int, double>& distances) const
+{
+    return shortestPaths(
+        startVertex, [&](int e) { return edgeWeightFunc(einfoData[e]); }, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename WeightFn>
+DigraphEdgeWeights FrozenDigraph<VertexInfo, EdgeInfo>::edgeWeights(WeightFn&& edgeWeightFunc) const
+{
+    DigraphEdgeWeights weights;
+    weights.weight.resize(topology.edgeCount());
+
+    for (int e = 0; e < topology.edgeCount(); ++e)
+    {
+        weights.weight[e] = edgeWeightFunc(einfoData[e]);
+    }
+
+    return weights;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPaths(
+    int startVertex, const DigraphEdgeWeights& weights) const
+{
+    std::map<int, double> distances;
+    return findShortestPaths(startVertex, weights, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPaths(
+    int startVertex, const DigraphEdgeWeights& weights,
+    std::map<int, double>& distances) const
+{
+    checkWeights(weights);
+    const double* weight = weights.weight.data();
+    return shortestPaths(startVertex, [weight](int e) { return weight[e]; }, distances);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename WeightAt>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::shortestPaths(
+    int startVertex, const WeightAt& weightAt,
+    std::map<int, double>& distances) const
+{
+    int start = indexOf(startVertex);
+
+    std::vector<double> distance;
+    std::vector<int> predecessor;
+    IndexedHeap<double> heap;
+
+    csrShortestPaths(topology, start, weightAt, distance, predecessor, heap);
+
+    distances = csrToMap(topology, distance);
+    return csrIndexMap(topology, predecessor);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+DigraphPathMatrix FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPathsMany(
+    const std::vector<int>& startVertices,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc,
+    unsigned threads) const
+{
+    return findShortestPathsMany(startVertices, edgeWeights(edgeWeightFunc), threads);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+DigraphPathMatrix FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPathsMany(
+    const std::vector<int>& startVertices,
+    const DigraphEdgeWeights& weights,
+    unsigned threads) const
+{
+    checkWeights(weights);
+
+    std::vector<int> sources;
+    sources.reserve(startVertices.size());
+
+    for (int startVertex : startVertices)
+    {
+        sources.push_back(indexOf(startVertex));
+    }
+
+    DigraphPathMatrix paths;
+    csrShortestPathsMany(topology, sources, weights.weight, paths, threads);
+    return paths;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPathsParallel(
+    int startVertex,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc,
+    double delta, unsigned threads) const
+{
+    std::map<int, double> distances;
+    return findShortestPathsParallel(startVertex, edgeWeights(edgeWeightFunc), distances, delta, threads);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPathsParallel(
+    int startVertex,
+    std::function<double(const EdgeInfo&)> edgeWeightFunc,
+    std::map<int, double>& distances,
+    double delta, unsigned threads) const
+{
+    return findShortestPathsParallel(startVertex, edgeWeights(edgeWeightFunc), distances, delta, threads);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPathsParallel(
+    int startVertex, const DigraphEdgeWeights& weights,
+    double delta, unsigned threads) const
+{
+    std::map<int, double> distances;
+    return findShortestPathsParallel(startVertex, weights, distances, delta, threads);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+std::map<int, int> FrozenDigraph<VertexInfo, EdgeInfo>::findShortestPathsParallel(
+    int startVertex, const DigraphEdgeWeights& weights,
+    std::map<int, double>& distances,
+    double delta, unsigned threads) const
+{
+    checkWeights(weights);
+    int start = indexOf(startVertex);
+
+    std::vector<double> distance;
+    std::vector<int> predecessor;
+    csrDeltaStepping(topology, start, weights.weight, delta, distance, predecessor, threads);
+
+    distances = csrToMap(topology, distance);
+    return csrIndexMap(topology, predecessor);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+DigraphCsrView FrozenDigraph<VertexInfo, EdgeInfo>::csr() const noexcept
+{
+    return topology;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+const EdgeInfo& FrozenDigraph<VertexInfo, EdgeInfo>::edgeInfoAt(int edge) const
+{
+    return einfoData[edge];
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+void FrozenDigraph<VertexInfo, EdgeInfo>::pointAtStorage() noexcept
+{
+    if (!mapping)
+    {
+        topology = storage;
+        vinfoData = vinfos.data();
+        einfoData = einfos.data();
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+int FrozenDigraph<VertexInfo, EdgeInfo>::indexOf(int vertex) const
+{
+    int i = topology.indexOf(vertex);
+
+    if (i < 0)
+    {
+        throw DigraphException("Vertex " + std::to_string(vertex) + " does not exist");
+    }
+
+    return i;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+int FrozenDigraph<VertexInfo, EdgeInfo>::edgeIndexOf(int from, int to) const
+{
+    int u = indexOf(from);
+    int v = indexOf(to);
+
+    for (int e = topology.offsets[u]; e < topology.offsets[u + 1]; ++e)
+    {
+        if (topology.targets[e] == v)
+        {
+            return e;
+        }
+    }
+
+    throw DigraphException("Edge does not exist");
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+void FrozenDigraph<VertexInfo, EdgeInfo>::checkWeights(const DigraphEdgeWeights& weights) const
+{
+    if (weights.weight.size() != static_cast<std::size_t>(topology.edgeCount()))
+    {
+        throw DigraphException(
+            "Edge weights have " + std::to_string(weights.weight.size()) + " entries for "
+            + std::to_string(topology.edgeCount()) + " edges");
+    }
+}
+
+
+
+#endif // FROZENDIGRAPH_HPP
@@ -0,0 +1,269 @@
+// IndexedHeap.hpp
+//
+// This header file declares a class template called IndexedHeap, which
+// is a d-ary min-heap of (priority, item) pairs in which the items are
+// dense integer indices in the range [0, capacity).  Because the heap
+// remembers where each item currently lives, it supports decrease-key
+// in O(log n), which is what Dijkstra-style algorithms need in order to
+// keep at most one heap entry per vertex.
+//
+// The arity defaults to 4, which keeps the tree shallow and lets the
+// children of a node share a cache line or two.
+
+#ifndef INDEXEDHEAP_HPP
+#define INDEXEDHEAP_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "DigraphStats.hpp"
+
+
+
+template <typename Priority, int Arity = 4>
+class IndexedHeap
+{
+public:
+    // The constructor initializes an empty heap that can hold the items
+    // 0 through capacity - 1.
+    explicit IndexedHeap(int capacity = 0);
+
+    // reset() empties the heap and makes room for the items 0 through
+    // capacity - 1.  Only the positions of items that were touched since
+    // the last reset are cleared, so resetting a heap of unchanged
+    // capacity costs time proportional to the work done since then.
+    void reset(int capacity);
+
+    // empty() returns true if there are no items in the heap.
+    bool empty() const noexcept;
+
+    // size() returns the number of items currently in the heap.
+    int size() const noexcept;
+
+    // contains() returns true if the given item is currently in the heap.
+    bool contains(int item) const noexcept;
+
+    // top() returns the item with the smallest priority, and
+    // topPriority() returns that priority.  Neither may be called on
+    // an empty heap.
+    int top() const noexcept;
+    const Priority& topPriority() const noexcept;
+
+    // pop() removes the item with the smallest priority and returns it.
+    int pop();
+
+    // push() inserts an item that is not already in the heap.
+    void push(int item, const Priority& priority);
+
+    // decrease() lowers the priority of an item that is in the heap.
+    void decrease(int item, const Priority& priority);
+
+    // pushOrDecrease() inserts the item if it is not in the heap and
+    // lowers its priority if it is.
+    void pushOrDecrease(int item, const Priority& priority);
+
+
+private:
+    std::vector<std::pair<Priority, int>> heap;
+    std::vector<int> position;
+    std::vector<int> touched;
+
+    void siftUp(int i);
+    void siftDown(int i);
+    void place(int i, std::pair<Priority, int>&& entry);
+};
+
+
+
+template <typename Priority, int Arity>
+IndexedHeap<Priority, Arity>::IndexedHeap(int capacity)
+    : position(static_cast<std::size_t>(capacity), -1)
+{
+}
+
+
+template <typename Priority, int Arity>
+void IndexedHeap<Priority, Arity>::reset(int capacity)
+{
+    if (static_cast<std::size_t>(capacity) != position.size())
+    {
+        DIGRAPH_STATS_ADD(allocations, static_cast<std::size_t>(capacity) > position.capacity());
+        position.assign(static_cast<std::size_t>(capacity), -1);
+    }
+    else
+    {
+        for (int item : touched)
+        {
+            position[item] = -1;
+        }
+    }
+
+    touched.clear();
+    heap.clear();
+}
+
+
+template <typename Priority, int Arity>
+bool IndexedHeap<Priority, Arity>::empty() const noexcept
+{
+    return heap.empty();
+}
+
+
+template <typename Priority, int Arity>
+int IndexedHeap<Priority, Arity>::size() const noexcept
+{
+    return static_cast<int>(heap.size());
+}
+
+
+template <typename Priority, int Arity>
+bool IndexedHeap<Priority, Arity>::contains(int item) const noexcept
+{
+    return position[item] >= 0;
+}
+
+
+template <typename Priority, int Arity>
+int IndexedHeap<Priority, Arity>::top() const noexcept
+{
+    return heap.front().second;
+}
+
+
+template <typename Priority, int Arity>
+const Priority& IndexedHeap<Priority, Arity>::topPriority() const noexcept
+{
+    return heap.front().first;
+}
+
+
+template <typename Priority, int Arity>
+int IndexedHeap<Priority, Arity>::pop()
+{
+    DIGRAPH_STATS_ADD(heapPops, 1);
+
+    int item = heap.front().second;
+    position[item] = -1;
+
+    std::pair<Priority, int> last = std::move(heap.back());
+    heap.pop_back();
+
+    if (!heap.empty())
+    {
+        place(0, std::move(last));
+        siftDown(0);
+    }
+
+    return item;
+}
+
+
+template <typename Priority, int Arity>
+void IndexedHeap<Priority, Arity>::push(int item, const Priority& priority)
+{
+    DIGRAPH_STATS_ADD(heapPushes, 1);
+
+    touched.push_back(item);
+    heap.emplace_back(priority, item);
+    position[item] = static_cast<int>(heap.size()) - 1;
+    siftUp(position[item]);
+}
+
+
+template <typename Priority, int Arity>
+void IndexedHeap<Priority, Arity>::decrease(int item, const Priority& priority)
+{
+    DIGRAPH_STATS_ADD(heapDecreases, 1);
+
+    int i = position[item];
+    heap[i].first = priority;
+    siftUp(i);
+}
+
+
+template <typename Priority, int Arity>
+void IndexedHeap<Priority, Arity>::pushOrDecrease(int item, const Priority& priority)
+{
+    if (contains(item))
+    {
+        decrease(item, priority);
+    }
+    else
+    {
+        push(item, priority);
+    }
+}
+
+
+template <typename Priority, int Arity>
+void IndexedHeap<Priority, Arity>::siftUp(int i)
+{
+    std::pair<Priority, int> entry = std::move(heap[i]);
+
+    while (i > 0)
+    {
+        int parent = (i - 1) / Arity;
+
+        if (!(entry.first < heap[parent].first))
+        {
+            break;
+        }
+
+        place(i, std::move(heap[parent]));
+        i = parent;
+    }
+
+    place(i, std::move(entry));
+}
+
+
+template <typename Priority, int Arity>
+void IndexedHeap<Priority, Arity>::siftDown(int i)
+{
+    int n = static_cast<int>(heap.size());
+    std::pair<Priority, int> entry = std::move(heap[i]);
+
+    while (true)
+    {
+        int first = i * Arity + 1;
+
+        if (first >= n)
+        {
+            break;
+        }
+
+        int last = first + Arity < n ? first + Arity : n;
+        int best = first;
+
+        for (int c = first + 1; c < last; ++c)
+        {
+            if (heap[c].first < heap[best].first)
+            {
+                best = c;
+            }
+        }
+
+        if (!(heap[best].first < entry.first))
+        {
+            break;
+        }
+
+        place(i, std::move(heap[best]));
+        i = best;
+    }
+
+    place(i, std::move(entry));
+}
+
+
+template <typename Priority, int Arity>
+void IndexedHeap<Priority, Arity>::place(int i, std::pair<Priority, int>&& entry)
+{
+    position[entry.second] = i;
+    heap[i] = std::move(entry);
+}
+
+
+
+#endif // INDEXEDHEAP_HPP
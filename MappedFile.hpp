@@ -0,0 +1,177 @@
+// MappedFile.hpp
+//
+// This header file declares a class called MappedFile, which makes the
+// contents of a file available as one read-only block of memory.  On
+// POSIX systems the file is memory-mapped, so opening even a very large
+// file is instant and its pages are only read from disk as they're
+// touched; elsewhere (or if mapping fails, as it does for pipes) the
+// file is read into a buffer instead.
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPEDFILE_USE_MMAP 1
+#endif
+
+
+
+class MappedFile
+{
+public:
+    // The default constructor initializes a MappedFile with no file.
+    MappedFile() noexcept;
+
+    // This constructor opens the file with the given path; use isOpen()
+    // to find out whether that worked.
+    explicit MappedFile(const std::string& path);
+
+    ~MappedFile() noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // open() closes whatever file was open and opens the file with the
+    // given path instead, returning true if that worked.
+    bool open(const std::string& path);
+
+    // close() unmaps (or frees) the file's contents.
+    void close() noexcept;
+
+    // isOpen() returns true if a file is open.  data() and size() return
+    // where its contents start and how many bytes there are.
+    bool isOpen() const noexcept;
+    const char* data() const noexcept;
+    std::size_t size() const noexcept;
+
+
+private:
+    const char* contents;
+    std::size_t length;
+    bool mapped;
+    bool opened;
+    std::vector<char> buffer;
+};
+
+
+
+inline MappedFile::MappedFile() noexcept
+    : contents{nullptr}, length{0}, mapped{false}, opened{false}
+{
+}
+
+
+inline MappedFile::MappedFile(const std::string& path)
+    : MappedFile()
+{
+    open(path);
+}
+
+
+inline MappedFile::~MappedFile() noexcept
+{
+    close();
+}
+
+
+inline bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#ifdef MAPPEDFILE_USE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd >= 0)
+    {
+        struct stat info;
+
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+        {
+            length = static_cast<std::size_t>(info.st_size);
+
+            if (length == 0)
+            {
+                ::close(fd);
+                opened = true;
+                return true;
+            }
+
+            void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (p != MAP_FAILED)
+            {
+                ::close(fd);
+                contents = static_cast<const char*>(p);
+                mapped = true;
+                opened = true;
+                return true;
+            }
+        }
+
+        ::close(fd);
+    }
+#endif
+
+    std::ifstream in{path, std::ios::binary};
+
+    if (!in)
+    {
+        length = 0;
+        return false;
+    }
+
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    contents = buffer.data();
+    length = buffer.size();
+    opened = true;
+    return true;
+}
+
+
+inline void MappedFile::close() noexcept
+{
+#ifdef MAPPEDFILE_USE_MMAP
+    if (mapped)
+    {
+        ::munmap(const_cast<char*>(contents), length);
+    }
+#endif
+
+    std::vector<char>().swap(buffer);
+    contents = nullptr;
+    length = 0;
+    mapped = false;
+    opened = false;
+}
+
+
+inline bool MappedFile::isOpen() const noexcept
+{
+    return opened;
+}
+
+
+inline const char* MappedFile::data() const noexcept
+{
+    return contents;
+}
+
+
+inline std::size_t MappedFile::size() const noexcept
+{
+    return length;
+}
+
+
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,1754 @@
+// benchmark.cpp
+//
+// This is a benchmark driver for the graph types in this directory:
+// Digraph, FrozenDigraph, ConcurrentDigraph, DynamicShortestPaths,
+// DynamicComponents, ContractionHierarchy and MyGraphType.  It builds
+// synthetic graphs of a chosen size, times each public operation on
+// them, prints a table and, if asked, writes the same results as JSON
+// so that runs can be compared over time.
+//
+// Three kinds of graphs are generated, all with vertex numbers 0
+// through V - 1:
+//
+// * er, an Erdos-Renyi random graph with E edges chosen uniformly
+// * rmat, a power-law graph with E edges chosen by the R-MAT recursive
+//   quadrant process (Chakrabarti, Zhan and Faloutsos), which has a
+//   few very high-degree vertices and many low-degree ones
+// * grid, a road-like square grid of about V vertices with an edge in
+//   each direction between neighbors (E is ignored); its vertices carry
+//   their coordinates, so A* can use them as a heuristic
+//
+// Each benchmark runs its operation repeatedly for at least the minimum
+// time and reports:
+//
+// * ns/op, the time per operation (an operation is one edge added, one
+//   query answered and so on, as the benchmark's name says)
+// * edges/s, the number of graph edges processed per second
+// * peak RSS, the process's peak resident set size so far, which only
+//   ever grows, so a benchmark that needs more memory than any before
+//   it shows up as a step
+//
+// Digraph is built and destroyed twice on each graph, once with its
+// memory from std::allocator and once from DigraphPoolAllocator, to
+// compare the two.  Peak RSS can't tell apart two graphs of the same
+// size built one after the other, so these build benchmarks also
+// report resident_kb, the resident memory one graph adds.
+//
+// Digraph/findShortestPaths(baseline) runs the search findShortestPaths()
+// made before it was a real Dijkstra search, and the searches after it
+// report their speedup over it.  That search takes time proportional
+// to V times E, so on big graphs it's by far the slowest benchmark.
+//
+// It builds on its own, like main.cpp:
+//
+//     g++ -std=c++11 -O2 -pthread benchmark.cpp -o benchmark
+//
+// Usage:
+//
+//     benchmark [--vertices V] [--edges E] [--graphs er,rmat,grid]
+//               [--filter TEXT] [--min-time SECONDS] [--threads N]
+//               [--json PATH] [--scratch PATH]
+//
+// --filter only runs the benchmarks whose "graph/benchmark" name
+// contains the given text; --threads is passed to the operations that
+// take a thread count (0 means one per hardware thread); --scratch is
+// the file used by the benchmarks that save and load graphs.
+//
+// The defaults make a quick check.  To measure graphs the size of the
+// road networks these types are meant for, with a million edges, run
+//
+//     benchmark --vertices 100000 --edges 1000000
+//
+// The parallel shortest path search is also run with 1, 2, 4 and so on
+// threads, up to --threads (or one per hardware thread), and reports
+// its speedup over one thread, to show how well it scales.  Graphs with
+// fewer than 16,384 vertices are always searched on one thread, so
+// these scaling runs skip them.  If every graph is that small, as with
+// the defaults, the scaling runs are made on an extra Erdos-Renyi graph
+// called scaling-er, with 32,768 vertices.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "ConcurrentDigraph.hpp"
+#include "ContractionHierarchy.hpp"
+#include "Digraph.hpp"
+#include "DigraphPool.hpp"
+#include "DynamicComponents.hpp"
+#include "DynamicShortestPaths.hpp"
+#include "FrozenDigraph.hpp"
+#include "directed_graph.hpp"
+
+
+
+// A BenchPoint is the VertexInfo of every benchmark graph: the vertex's
+// coordinates on the grid, or zero for the other kinds of graphs.
+
+struct BenchPoint
+{
+    double x;
+    double y;
+};
+
+
+// A BenchGraph is a generated graph, ready to be loaded into any of
+// the graph types.  Every edge's EdgeInfo is its weight.
+
+struct BenchGraph
+{
+    std::string name;
+    int vertices;
+    std::vector<BenchPoint> points;
+    std::vector<DigraphEdge<double>> edges;
+    bool hasCoordinates;
+};
+
+
+typedef Digraph<BenchPoint, double> BenchDigraph;
+
+
+
+// erdosRenyi(), rmat() and grid() generate the three kinds of graphs.
+// The random graphs never have loops or parallel edges, and their
+// weights are spread evenly between 1 and 10.
+
+BenchGraph erdosRenyi(int vertices, long long edges, std::mt19937_64& random)
+{
+    BenchGraph graph{"er", vertices, std::vector<BenchPoint>(vertices, BenchPoint{0.0, 0.0}), {}, false};
+    edges = std::min(edges, static_cast<long long>(vertices) * (vertices - 1));
+
+    std::uniform_int_distribution<int> vertex{0, vertices - 1};
+    std::uniform_real_distribution<double> weight{1.0, 10.0};
+    std::unordered_set<long long> seen;
+
+    while (static_cast<long long>(graph.edges.size()) < edges)
+    {
+        int from = vertex(random);
+        int to = vertex(random);
+
+        if (from != to && seen.insert(static_cast<long long>(from) * vertices + to).second)
+        {
+            graph.edges.push_back(DigraphEdge<double>{from, to, weight(random)});
+        }
+    }
+
+    return graph;
+}
+
+
+BenchGraph rmat(int vertices, long long edges, std::mt19937_64& random)
+{
+    // These are the quadrant probabilities used by the Graph500
+    // benchmark; the fourth is what's left over.
+    const double a = 0.57;
+    const double b = 0.19;
+    const double c = 0.19;
+
+    BenchGraph graph{"rmat", vertices, std::vector<BenchPoint>(vertices, BenchPoint{0.0, 0.0}), {}, false};
+
+    int scale = 0;
+
+    while ((1LL << scale) < vertices)
+    {
+        ++scale;
+    }
+
+    std::uniform_real_distribution<double> unit{0.0, 1.0};
+    std::uniform_real_distribution<double> weight{1.0, 10.0};
+    std::unordered_set<long long> seen;
+
+    // The skew means duplicates get common as the graph fills up, so
+    // generation gives up after a generous number of attempts.
+    for (long long attempts = 0;
+         static_cast<long long>(graph.edges.size()) < edges && attempts < 20 * edges;
+         ++attempts)
+    {
+        long long from = 0;
+        long long to = 0;
+
+        for (int bit = 0; bit < scale; ++bit)
+        {
+            double p = unit(random);
+            from = from * 2 + (p >= a + b ? 1 : 0);
+            to = to * 2 + ((p >= a && p < a + b) || p >= a + b + c ? 1 : 0);
+        }
+
+        if (from < vertices && to < vertices && from != to
+            && seen.insert(from * vertices + to).second)
+        {
+            graph.edges.push_back(DigraphEdge<double>{
+                static_cast<int>(from), static_cast<int>(to), weight(random)});
+        }
+    }
+
+    return graph;
+}
+
+
+BenchGraph grid(int vertices, std::mt19937_64& random)
+{
+    int side = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(vertices))));
+
+    BenchGraph graph{"grid", side * side, {}, {}, true};
+
+    // Each edge's weight is at least the distance between its ends, so
+    // the Manhattan distance never overestimates and A* stays exact.
+    std::uniform_real_distribution<double> extra{0.0, 1.0};
+
+    for (int y = 0; y < side; ++y)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            graph.points.push_back(BenchPoint{static_cast<double>(x), static_cast<double>(y)});
+        }
+    }
+
+    for (int y = 0; y < side; ++y)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            int v = y * side + x;
+
+            if (x + 1 < side)
+            {
+                graph.edges.push_back(DigraphEdge<double>{v, v + 1, 1.0 + extra(random)});
+                graph.edges.push_back(DigraphEdge<double>{v + 1, v, 1.0 + extra(random)});
+            }
+
+            if (y + 1 < side)
+            {
+                graph.edges.push_back(DigraphEdge<double>{v, v + side, 1.0 + extra(random)});
+                graph.edges.push_back(DigraphEdge<double>{v + side, v, 1.0 + extra(random)});
+            }
+        }
+    }
+
+    return graph;
+}
+
+
+
+// buildDigraph() loads a generated graph into a Digraph one vertex and
+// one edge at a time.  The Digraph's memory comes from the given
+// allocator, or from std::allocator if none is given.
+
+template <typename Allocator = std::allocator<char>>
+Digraph<BenchPoint, double, Allocator> buildDigraph(const BenchGraph& graph)
+{
+    Digraph<BenchPoint, double, Allocator> d;
+
+    for (int v = 0; v < graph.vertices; ++v)
+    {
+        d.addVertex(v, graph.points[v]);
+    }
+
+    for (const DigraphEdge<double>& e : graph.edges)
+    {
+        d.addEdge(e.fromVertex, e.toVertex, e.einfo);
+    }
+
+    return d;
+}
+
+
+// writeAdjacencyFile() writes a generated graph in the text format that
+// MyGraphType::loadFromFile() reads.
+
+bool writeAdjacencyFile(const BenchGraph& graph, const std::string& path)
+{
+    std::vector<std::vector<int>> adjacent(graph.vertices);
+
+    for (const DigraphEdge<double>& e : graph.edges)
+    {
+        adjacent[e.fromVertex].push_back(e.toVertex);
+    }
+
+    std::ofstream out{path};
+    out << graph.vertices << '\n';
+
+    for (int v = 0; v < graph.vertices; ++v)
+    {
+        out << v;
+
+        for (int w : adjacent[v])
+        {
+            out << ' ' << w;
+        }
+
+        out << " -999\n";
+    }
+
+    out.close();
+    return !out.fail();
+}
+
+
+// randomVertices() returns count vertex numbers of the given graph,
+// chosen at random but the same every run.
+
+std::vector<int> randomVertices(const BenchGraph& graph, int count, std::uint64_t seed)
+{
+    std::mt19937_64 random{seed};
+    std::uniform_int_distribution<int> vertex{0, graph.vertices - 1};
+    std::vector<int> chosen;
+
+    for (int i = 0; i < count; ++i)
+    {
+        chosen.push_back(vertex(random));
+    }
+
+    return chosen;
+}
+
+
+// baselineShortestPaths() is findShortestPaths() as it was before it
+// became a Dijkstra search over dense arrays, kept here so that the
+// benchmarks can show the difference: it pops the highest vertex number
+// rather than the closest vertex, keeps distances in a std::map<int,
+// int>, and looks up whether a vertex is settled with a linear search,
+// which makes it take time proportional to V times E.
+
+std::map<int, int> baselineShortestPaths(
+    const BenchDigraph& d, int startVertex,
+    std::function<double(const double&)> edgeWeightFunc)
+{
+    std::vector<int> vertex_list;
+    std::map<int, int> vertex_d;
+    std::map<int, int> vertex_p;
+
+    for (int v : d.vertices())
+    {
+        if (v == startVertex)
+        {
+            vertex_d[v] = 0;
+            vertex_p[v] = v;
+        }
+        else
+        {
+            vertex_d[v] = INT_MAX;
+        }
+    }
+
+    std::priority_queue<int> pq;
+    pq.push(startVertex);
+
+    while (!pq.empty())
+    {
+        int min_priority_vertex = pq.top();
+        pq.pop();
+
+        if (std::find(vertex_list.begin(), vertex_list.end(), min_priority_vertex) == vertex_list.end())
+        {
+            vertex_list.push_back(min_priority_vertex);
+
+            for (const DigraphEdge<double>& v : d.outEdges(min_priority_vertex))
+            {
+                if (vertex_d[v.toVertex] > vertex_d[v.fromVertex] + edgeWeightFunc(v.einfo))
+                {
+                    vertex_d[v.toVertex] = vertex_d[v.fromVertex] + edgeWeightFunc(v.einfo);
+                    vertex_p[v.toVertex] = min_priority_vertex;
+                    pq.push(v.toVertex);
+                }
+            }
+        }
+    }
+
+    return vertex_p;
+}
+
+
+// A DiscardBuffer is a stream buffer that throws away whatever is
+// written to it, so that operations that print can be timed without
+// filling the screen.
+
+class DiscardBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override
+    {
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+
+// peakRssKb() returns the peak resident set size of the process so far,
+// in kilobytes.
+
+long peakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+
+// residentKb() returns the resident set size of the process right now,
+// in kilobytes, or zero if the system won't say.  Memory the process
+// has freed may stay resident, so releaseFreeMemory() asks the C
+// library to give back what it can first, where it knows how.
+
+long residentKb()
+{
+    std::ifstream statm{"/proc/self/statm"};
+    long size = 0;
+    long resident = 0;
+
+    if (!(statm >> size >> resident))
+    {
+        return 0;
+    }
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+
+void releaseFreeMemory()
+{
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+
+
+struct BenchOptions
+{
+    int vertices;
+    long long edges;
+    std::vector<std::string> graphs;
+    std::string filter;
+    double minTime;
+    unsigned threads;
+    std::string jsonPath;
+    std::string scratchPath;
+};
+
+
+struct BenchResult
+{
+    std::string graph;
+    int vertices;
+    long long edges;
+    std::string name;
+    long long iterations;
+    double nsPerOp;
+    double edgesPerSecond;
+    long peakRssKb;
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+
+
+// A BenchRunner runs benchmarks and collects their results.
+
+class BenchRunner
+{
+public:
+    explicit BenchRunner(const BenchOptions& options);
+
+    // wants() returns true if the benchmark with the given name on the
+    // given graph passes the filter.  Benchmarks that need expensive
+    // setup check it before doing any.
+    bool wants(const BenchGraph& graph, const std::string& name) const;
+
+    // run() times op, each call of which performs ops operations and
+    // processes edges edges, and records the result, unless the
+    // benchmark is filtered out.
+    void run(
+        const BenchGraph& graph, const std::string& name,
+        long long ops, long long edges, const std::function<void()>& op);
+
+    // runTimed() is like run(), except that op times itself: it returns
+    // the seconds taken by the part of it being measured, so that setup
+    // it needs every time (like building a graph to destroy) isn't
+    // counted.
+    void runTimed(
+        const BenchGraph& graph, const std::string& name,
+        long long ops, long long edges, const std::function<double()>& op);
+
+    // counter() attaches an extra named value to the result of the
+    // benchmark that was run last, if it wasn't filtered out.
+    void counter(const std::string& name, double value);
+
+    // lastNsPerOp() returns the time per operation of the benchmark
+    // that was run last, or zero if it was filtered out.
+    double lastNsPerOp() const;
+
+    // writeJson() writes every result as a JSON document.
+    void writeJson(std::ostream& out) const;
+
+
+private:
+    // record() prints and keeps the result of a benchmark that took the
+    // given number of seconds over the given number of iterations.
+    void record(
+        const BenchGraph& graph, const std::string& name,
+        long long ops, long long edges, long long iterations, double elapsed);
+
+    BenchOptions options;
+    std::vector<BenchResult> results;
+    bool lastRan;
+};
+
+
+
+BenchRunner::BenchRunner(const BenchOptions& options)
+    : options{options}, lastRan{false}
+{
+    std::printf("%-60s %14s %14s %12s\n", "benchmark", "ns/op", "edges/s", "peak RSS KB");
+}
+
+
+bool BenchRunner::wants(const BenchGraph& graph, const std::string& name) const
+{
+    return (graph.name + "/" + name).find(options.filter) != std::string::npos;
+}
+
+
+void BenchRunner::run(
+    const BenchGraph& graph, const std::string& name,
+    long long ops, long long edges, const std::function<void()>& op)
+{
+    lastRan = wants(graph, name);
+
+    if (!lastRan)
+    {
+        return;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+
+    long long iterations = 0;
+    double elapsed = 0.0;
+    Clock::time_point start = Clock::now();
+
+    while (iterations == 0 || elapsed < options.minTime)
+    {
+        op();
+        ++iterations;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    record(graph, name, ops, edges, iterations, elapsed);
+}
+
+
+void BenchRunner::runTimed(
+    const BenchGraph& graph, const std::string& name,
+    long long ops, long long edges, const std::function<double()>& op)
+{
+    lastRan = wants(graph, name);
+
+    if (!lastRan)
+    {
+        return;
+    }
+
+    long long iterations = 0;
+    double elapsed = 0.0;
+
+    while (iterations == 0 || elapsed < options.minTime)
+    {
+        elapsed += op();
+        ++iterations;
+    }
+
+    record(graph, name, ops, edges, iterations, elapsed);
+}
+
+
+void BenchRunner::record(
+    const BenchGraph& graph, const std::string& name,
+    long long ops, long long edges, long long iterations, double elapsed)
+{
+    BenchResult result{
+        graph.name, graph.vertices, static_cast<long long>(graph.edges.size()), name,
+        iterations, elapsed * 1e9 / (static_cast<double>(iterations) * std::max(ops, 1LL)),
+        static_cast<double>(edges) * iterations / elapsed, peakRssKb(), {}};
+
+    std::printf("%-60s %14.1f %14.4g %12ld\n",
+                (graph.name + "/" + name).c_str(), result.nsPerOp, result.edgesPerSecond, result.peakRssKb);
+    std::fflush(stdout);
+
+    results.push_back(result);
+}
+
+
+void BenchRunner::counter(const std::string& name, double value)
+{
+    if (lastRan)
+    {
+        results.back().counters.emplace_back(name, value);
+        std::printf("    %s = %g\n", name.c_str(), value);
+    }
+}
+
+
+double BenchRunner::lastNsPerOp() const
+{
+    return lastRan ? results.back().nsPerOp : 0.0;
+}
+
+
+void BenchRunner::writeJson(std::ostream& out) const
+{
+    auto quote = [](const std::string& text)
+    {
+        std::string quoted = "\"";
+
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                quoted += '\\';
+            }
+
+            quoted += c;
+        }
+
+        return quoted + "\"";
+    };
+
+    out << "{\n  \"benchmarks\": [";
+
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult& r = results[i];
+
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\"graph\": " << quote(r.graph)
+            << ", \"vertices\": " << r.vertices
+            << ", \"edges\": " << r.edges
+            << ", \"name\": " << quote(r.name)
+            << ", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.nsPerOp
+            << ", \"edges_per_second\": " << r.edgesPerSecond
+            << ", \"peak_rss_kb\": " << r.peakRssKb;
+
+        for (const std::pair<std::string, double>& c : r.counters)
+        {
+            out << ", " << quote(c.first) << ": " << c.second;
+        }
+
+        out << "}";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+
+
+// The benchmarks for each graph type follow.  Each one that uses the
+// result of an operation folds it into sink, so the compiler can't
+// throw the operation away.
+
+volatile long long sink;
+
+
+// benchmarkAllocator() times building and destroying the same graph
+// with a Digraph whose memory comes from the given allocator, and says
+// how much resident memory one such graph adds to the process.  It's
+// run once with std::allocator and once with DigraphPoolAllocator, so
+// the two can be compared side by side.
+
+template <typename Allocator>
+void benchmarkAllocator(BenchRunner& runner, const BenchGraph& graph, const std::string& allocatorName)
+{
+    typedef Digraph<BenchPoint, double, Allocator> AllocatorDigraph;
+    typedef std::chrono::steady_clock Clock;
+
+    long long e = static_cast<long long>(graph.edges.size());
+    std::string prefix = "Digraph(" + allocatorName + ")/";
+    long resident = 0;
+
+    if (runner.wants(graph, prefix + "build per edge"))
+    {
+        releaseFreeMemory();
+        long before = residentKb();
+        AllocatorDigraph d = buildDigraph<Allocator>(graph);
+        resident = residentKb() - before;
+    }
+
+    runner.run(graph, prefix + "build per edge", e, e, [&]
+    {
+        AllocatorDigraph d = buildDigraph<Allocator>(graph);
+        sink = d.edgeCount();
+    });
+
+    runner.counter("resident_kb", static_cast<double>(resident));
+
+    runner.runTimed(graph, prefix + "destroy per edge", e, e, [&]
+    {
+        std::unique_ptr<AllocatorDigraph> d{new AllocatorDigraph{buildDigraph<Allocator>(graph)}};
+        Clock::time_point start = Clock::now();
+        d.reset();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    });
+}
+
+
+void benchmarkDigraph(BenchRunner& runner, const BenchGraph& graph, const BenchOptions& options)
+{
+    long long v = graph.vertices;
+    long long e = static_cast<long long>(graph.edges.size());
+    auto weight = [](const double& w) { return w; };
+
+    runner.run(graph, "Digraph/addVertex+addEdge per edge", e, e, [&]
+    {
+        BenchDigraph d = buildDigraph(graph);
+        sink = d.edgeCount();
+    });
+
+    runner.run(graph, "Digraph/addVertices+addEdges per edge", e, e, [&]
+    {
+        std::vector<std::pair<int, BenchPoint>> vertices;
+
+        for (int i = 0; i < graph.vertices; ++i)
+        {
+            vertices.emplace_back(i, graph.points[i]);
+        }
+
+        BenchDigraph d;
+        d.addVertices(vertices);
+        d.addEdges(graph.edges);
+        sink = d.edgeCount();
+    });
+
+    BenchDigraph d = buildDigraph(graph);
+    std::vector<int> sources = randomVertices(graph, 64, 1);
+    std::vector<int> targets = randomVertices(graph, 64, 2);
+
+    std::vector<DigraphEdge<double>> sample;
+
+    for (int i = 0; i < 1000 && !graph.edges.empty(); ++i)
+    {
+        sample.push_back(graph.edges[(static_cast<long long>(i) * 7919) % e]);
+    }
+
+    long long sampled = static_cast<long long>(sample.size());
+    typedef std::chrono::steady_clock Clock;
+
+    runner.run(graph, "Digraph/edges() per edge", e, e, [&]
+    {
+        sink = static_cast<long long>(d.edges().size());
+    });
+
+    runner.run(graph, "Digraph/edges(v) per vertex", v, e, [&]
+    {
+        for (int i = 0; i < graph.vertices; ++i)
+        {
+            sink = static_cast<long long>(d.edges(i).size());
+        }
+    });
+
+    runner.run(graph, "Digraph/allEdges() per edge", e, e, [&]
+    {
+        long long count = 0;
+
+        for (const DigraphEdge<double>& edge : d.allEdges())
+        {
+            count += edge.toVertex;
+        }
+
+        sink = count;
+    });
+
+    runner.run(graph, "Digraph/edgeInfo", sampled, 0, [&]
+    {
+        double total = 0.0;
+
+        for (const DigraphEdge<double>& edge : sample)
+        {
+            total += d.edgeInfo(edge.fromVertex, edge.toVertex);
+        }
+
+        sink = static_cast<long long>(total);
+    });
+
+    runner.run(graph, "Digraph/vertexCount+edgeCount", 1000, 0, [&]
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            sink = d.vertexCount() + d.edgeCount();
+        }
+    });
+
+    runner.run(graph, "Digraph/removeEdge+addEdge", sampled, 0, [&]
+    {
+        for (const DigraphEdge<double>& edge : sample)
+        {
+            d.removeEdge(edge.fromVertex, edge.toVertex);
+            d.addEdge(edge.fromVertex, edge.toVertex, edge.einfo);
+        }
+    });
+
+    // The removals below are timed on their own; the graph is put back
+    // together after each round, untimed.  The sample can name an edge
+    // more than once on a small graph, so they remove each edge in it
+    // once.
+    auto before = [](const DigraphEdge<double>& a, const DigraphEdge<double>& b)
+    {
+        return std::make_pair(a.fromVertex, a.toVertex) < std::make_pair(b.fromVertex, b.toVertex);
+    };
+
+    auto same = [](const DigraphEdge<double>& a, const DigraphEdge<double>& b)
+    {
+        return a.fromVertex == b.fromVertex && a.toVertex == b.toVertex;
+    };
+
+    std::vector<DigraphEdge<double>> distinct = sample;
+    std::sort(distinct.begin(), distinct.end(), before);
+    distinct.erase(std::unique(distinct.begin(), distinct.end(), same), distinct.end());
+
+    std::vector<std::pair<int, int>> distinctPairs;
+
+    for (const DigraphEdge<double>& edge : distinct)
+    {
+        distinctPairs.emplace_back(edge.fromVertex, edge.toVertex);
+    }
+
+    long long removed = static_cast<long long>(distinct.size());
+
+    runner.runTimed(graph, "Digraph/removeEdge", removed, 0, [&]
+    {
+        Clock::time_point start = Clock::now();
+
+        for (const DigraphEdge<double>& edge : distinct)
+        {
+            d.removeEdge(edge.fromVertex, edge.toVertex);
+        }
+
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        d.addEdges(distinct);
+        return elapsed;
+    });
+
+    runner.runTimed(graph, "Digraph/removeEdges per edge", removed, removed, [&]
+    {
+        Clock::time_point start = Clock::now();
+        d.removeEdges(distinctPairs);
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        d.addEdges(distinct);
+        return elapsed;
+    });
+
+    // removeVertex() takes every edge into and out of the vertex with
+    // it, so those edges are remembered, to be put back afterward.
+    std::vector<int> doomed = randomVertices(graph, 64, 5);
+    std::sort(doomed.begin(), doomed.end());
+    doomed.erase(std::unique(doomed.begin(), doomed.end()), doomed.end());
+
+    std::vector<std::vector<DigraphEdge<double>>> doomedEdges;
+    long long doomedDegree = 0;
+
+    for (int vertex : doomed)
+    {
+        auto out = d.outEdges(vertex);
+        std::vector<DigraphEdge<double>> edges(out.begin(), out.end());
+
+        for (const std::pair<int, int>& in : d.inEdges(vertex))
+        {
+            if (in.first != vertex)
+            {
+                edges.push_back(DigraphEdge<double>{in.first, in.second, d.edgeInfo(in.first, in.second)});
+            }
+        }
+
+        doomedDegree += static_cast<long long>(edges.size());
+        doomedEdges.push_back(edges);
+    }
+
+    runner.runTimed(graph, "Digraph/removeVertex", static_cast<long long>(doomed.size()), doomedDegree, [&]
+    {
+        double elapsed = 0.0;
+
+        for (std::size_t i = 0; i < doomed.size(); ++i)
+        {
+            Clock::time_point start = Clock::now();
+            d.removeVertex(doomed[i]);
+            elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+
+            d.addVertex(doomed[i], graph.points[doomed[i]]);
+            d.addEdges(doomedEdges[i]);
+        }
+
+        return elapsed;
+    });
+
+    runner.run(graph, "Digraph/isStronglyConnected", 1, e, [&]
+    {
+        sink = d.isStronglyConnected();
+    });
+
+    runner.run(graph, "Digraph/stronglyConnectedComponents", 1, e, [&]
+    {
+        sink = static_cast<long long>(d.stronglyConnectedComponents().members.size());
+    });
+
+    runner.run(graph, "Digraph/depthFirstTraversal", 1, e, [&]
+    {
+        long long count = 0;
+        d.depthFirstTraversal([&](int) { ++count; }, [](int) {});
+        sink = count;
+    });
+
+    runner.run(graph, "Digraph/breadthFirstSearch", 1, e, [&]
+    {
+        sink = d.breadthFirstSearch(sources[0], options.threads).level.back();
+    });
+
+    std::size_t next = 0;
+
+    // The search findShortestPaths() replaced is run first, so that the
+    // searches after it can report their speedup over it.
+    runner.run(graph, "Digraph/findShortestPaths(baseline)", 1, e, [&]
+    {
+        sink = static_cast<long long>(baselineShortestPaths(d, sources[next++ % sources.size()], weight).size());
+    });
+
+    double baseline = runner.lastNsPerOp();
+
+    runner.run(graph, "Digraph/findShortestPaths(std::function)", 1, e, [&]
+    {
+        std::function<double(const double&)> w = weight;
+        sink = static_cast<long long>(d.findShortestPaths(sources[next++ % sources.size()], w).size());
+    });
+
+    runner.run(graph, "Digraph/findShortestPaths(template)", 1, e, [&]
+    {
+        sink = static_cast<long long>(d.findShortestPaths(sources[next++ % sources.size()], weight).size());
+    });
+
+    if (baseline > 0.0 && runner.lastNsPerOp() > 0.0)
+    {
+        runner.counter("speedup_over_baseline", baseline / runner.lastNsPerOp());
+    }
+
+    std::vector<int> many(sources.begin(), sources.begin() + 16);
+
+    runner.run(graph, "Digraph/findShortestPathsMany per source", 16, 16 * e, [&]
+    {
+        sink = static_cast<long long>(d.findShortestPathsMany(many, weight, options.threads).distance.size());
+    });
+
+    runner.run(graph, "Digraph/findShortestPathsParallel", 1, e, [&]
+    {
+        sink = static_cast<long long>(
+            d.findShortestPathsParallel(sources[next++ % sources.size()], weight, 0.0, options.threads).size());
+    });
+
+    // The point-to-point searches report how many vertices they settle
+    // on average, next to the number a full shortest path tree settles
+    // (every vertex reachable from the source).
+    std::map<int, double> distances;
+    d.findShortestPaths(sources[0], weight, distances);
+
+    double reachable = static_cast<double>(std::count_if(
+        distances.begin(), distances.end(),
+        [](const std::pair<const int, double>& p) { return !std::isinf(p.second); }));
+
+    long long settled = 0;
+    long long queries = 0;
+
+    runner.run(graph, "Digraph/shortestPath(bidirectional)", 64, 0, [&]
+    {
+        for (std::size_t i = 0; i < sources.size(); ++i)
+        {
+            settled += d.shortestPath(sources[i], targets[i], weight).settled;
+            ++queries;
+        }
+    });
+
+    runner.counter("settled_per_query", static_cast<double>(settled) / std::max(queries, 1LL));
+    runner.counter("full_tree_settled", reachable);
+
+    if (graph.hasCoordinates)
+    {
+        auto manhattan = [](const BenchPoint& p, const BenchPoint& q)
+        {
+            return std::fabs(p.x - q.x) + std::fabs(p.y - q.y);
+        };
+
+        settled = 0;
+        queries = 0;
+
+        runner.run(graph, "Digraph/shortestPath(A*)", 64, 0, [&]
+        {
+            for (std::size_t i = 0; i < sources.size(); ++i)
+            {
+                settled += d.shortestPath(sources[i], targets[i], weight, manhattan).settled;
+                ++queries;
+            }
+        });
+
+        runner.counter("settled_per_query", static_cast<double>(settled) / std::max(queries, 1LL));
+        runner.counter("full_tree_settled", reachable);
+    }
+
+    runner.run(graph, "Digraph/save+load", 1, e, [&]
+    {
+        d.save(options.scratchPath);
+        sink = BenchDigraph::load(options.scratchPath).edgeCount();
+    });
+
+    std::remove(options.scratchPath.c_str());
+}
+
+
+void benchmarkFrozenDigraph(BenchRunner& runner, const BenchGraph& graph, const BenchOptions& options)
+{
+    long long e = static_cast<long long>(graph.edges.size());
+    auto weight = [](const double& w) { return w; };
+
+    BenchDigraph d = buildDigraph(graph);
+
+    runner.run(graph, "FrozenDigraph/freeze per edge", e, e, [&]
+    {
+        FrozenDigraph<BenchPoint, double> f{d};
+        sink = f.edgeCount();
+    });
+
+    FrozenDigraph<BenchPoint, double> f{d};
+    DigraphEdgeWeights weights = f.edgeWeights(weight);
+    std::vector<int> sources = randomVertices(graph, 64, 1);
+    std::size_t next = 0;
+
+    runner.run(graph, "FrozenDigraph/edges() per edge", e, e, [&]
+    {
+        sink = static_cast<long long>(f.edges().size());
+    });
+
+    runner.run(graph, "FrozenDigraph/isStronglyConnected", 1, e, [&]
+    {
+        sink = f.isStronglyConnected();
+    });
+
+    runner.run(graph, "FrozenDigraph/breadthFirstSearch", 1, e, [&]
+    {
+        sink = f.breadthFirstSearch(sources[0], options.threads).level.back();
+    });
+
+    runner.run(graph, "FrozenDigraph/findShortestPaths(template)", 1, e, [&]
+    {
+        sink = static_cast<long long>(f.findShortestPaths(sources[next++ % sources.size()], weight).size());
+    });
+
+    runner.run(graph, "FrozenDigraph/findShortestPaths(precomputed)", 1, e, [&]
+    {
+        sink = static_cast<long long>(f.findShortestPaths(sources[next++ % sources.size()], weights).size());
+    });
+
+    std::vector<int> many(sources.begin(), sources.begin() + 16);
+
+    runner.run(graph, "FrozenDigraph/findShortestPathsMany per source", 16, 16 * e, [&]
+    {
+        sink = static_cast<long long>(f.findShortestPathsMany(many, weights, options.threads).distance.size());
+    });
+
+    runner.run(graph, "FrozenDigraph/findShortestPathsParallel", 1, e, [&]
+    {
+        sink = static_cast<long long>(
+            f.findShortestPathsParallel(sources[next++ % sources.size()], weights, 0.0, options.threads).size());
+    });
+
+    runner.run(graph, "FrozenDigraph/save+load", 1, e, [&]
+    {
+        f.save(options.scratchPath);
+        sink = FrozenDigraph<BenchPoint, double>::load(options.scratchPath).edgeCount();
+    });
+
+    std::remove(options.scratchPath.c_str());
+}
+
+
+// benchmarkScaling() runs the parallel shortest path search with 1, 2,
+// 4 and so on threads and reports its speedup over one thread.  Graphs
+// with fewer than csrParallelDeltaSteppingThreshold vertices are always
+// searched on one thread, so it runs nothing on them, and returns false
+// to say so.  It also returns false if the filter leaves out every run.
+
+bool benchmarkScaling(BenchRunner& runner, const BenchGraph& graph, const BenchOptions& options)
+{
+    unsigned maxThreads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> teams;
+    bool wanted = false;
+
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, maxThreads))
+    {
+        teams.push_back(threads);
+        wanted = wanted || runner.wants(graph, "FrozenDigraph/findShortestPathsParallel threads=" + std::to_string(threads));
+
+        if (threads >= maxThreads)
+        {
+            break;
+        }
+    }
+
+    if (!wanted)
+    {
+        return false;
+    }
+
+    long long e = static_cast<long long>(graph.edges.size());
+    auto weight = [](const double& w) { return w; };
+
+    FrozenDigraph<BenchPoint, double> f{buildDigraph(graph)};
+
+    if (f.vertexCount() < csrParallelDeltaSteppingThreshold)
+    {
+        return false;
+    }
+
+    DigraphEdgeWeights weights = f.edgeWeights(weight);
+    std::vector<int> sources = randomVertices(graph, 64, 1);
+    std::size_t next = 0;
+    double oneThread = 0.0;
+
+    for (unsigned threads : teams)
+    {
+        runner.run(graph, "FrozenDigraph/findShortestPathsParallel threads=" + std::to_string(threads), 1, e, [&]
+        {
+            sink = static_cast<long long>(
+                f.findShortestPathsParallel(sources[next++ % sources.size()], weights, 0.0, threads).size());
+        });
+
+        if (threads == 1)
+        {
+            oneThread = runner.lastNsPerOp();
+        }
+        else if (oneThread > 0.0 && runner.lastNsPerOp() > 0.0)
+        {
+            runner.counter("speedup", oneThread / runner.lastNsPerOp());
+        }
+    }
+
+    return true;
+}
+
+
+void benchmarkConcurrentDigraph(BenchRunner& runner, const BenchGraph& graph, const BenchOptions& options)
+{
+    long long e = static_cast<long long>(graph.edges.size());
+
+    if (e == 0)
+    {
+        return;
+    }
+
+    ConcurrentDigraph<BenchPoint, double> c{buildDigraph(graph)};
+    const DigraphEdge<double>& edge = graph.edges.front();
+
+    runner.run(graph, "ConcurrentDigraph/update+publish", 1, e, [&]
+    {
+        c.update([&](BenchDigraph& d)
+        {
+            d.removeEdge(edge.fromVertex, edge.toVertex);
+            d.addEdge(edge.fromVertex, edge.toVertex, edge.einfo);
+        });
+    });
+
+    // Readers should never wait for writers, so snapshot() is timed
+    // while another thread publishes new versions as fast as it can.
+    std::atomic<bool> stop{false};
+    unsigned long before = c.version();
+
+    std::thread writer{[&]
+    {
+        while (!stop)
+        {
+            c.update([&](BenchDigraph& d)
+            {
+                d.removeEdge(edge.fromVertex, edge.toVertex);
+                d.addEdge(edge.fromVertex, edge.toVertex, edge.einfo);
+            });
+        }
+    }};
+
+    runner.run(graph, "ConcurrentDigraph/snapshot under writes", 1000, 0, [&]
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            sink = c.snapshot()->edgeCount();
+        }
+    });
+
+    stop = true;
+    writer.join();
+
+    runner.counter("versions_published", static_cast<double>(c.version() - before));
+
+    // The read-mostly workload: a team of threads runs shortest path
+    // queries on snapshots, except that one operation in a hundred is a
+    // write, which publishes a new version, instead.  ns/op is the wall
+    // time per operation of the whole team.
+    unsigned readers = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const int opsPerReader = 200;
+    std::vector<int> sources = randomVertices(graph, opsPerReader, 2);
+    auto weight = [](const double& w) { return w; };
+    auto isWrite = [](unsigned t, int i) { return (i + t) % 100 == 0; };
+    long long reads = 0;
+
+    for (unsigned t = 0; t < readers; ++t)
+    {
+        for (int i = 0; i < opsPerReader; ++i)
+        {
+            reads += !isWrite(t, i);
+        }
+    }
+
+    long long ops = static_cast<long long>(readers) * opsPerReader;
+    before = c.version();
+
+    runner.run(graph, "ConcurrentDigraph/findShortestPaths with 1% writes", ops, reads * e, [&]
+    {
+        auto work = [&](unsigned t)
+        {
+            long long found = 0;
+
+            for (int i = 0; i < opsPerReader; ++i)
+            {
+                if (isWrite(t, i))
+                {
+                    c.update([&](BenchDigraph& d)
+                    {
+                        d.removeEdge(edge.fromVertex, edge.toVertex);
+                        d.addEdge(edge.fromVertex, edge.toVertex, edge.einfo);
+                    });
+                }
+                else
+                {
+                    found += static_cast<long long>(c.snapshot()->findShortestPaths(sources[i], weight).size());
+                }
+            }
+
+            return found;
+        };
+
+        std::vector<long long> found(readers);
+        std::vector<std::thread> team;
+
+        for (unsigned t = 1; t < readers; ++t)
+        {
+            team.emplace_back([&, t] { found[t] = work(t); });
+        }
+
+        found[0] = work(0);
+
+        for (std::thread& member : team)
+        {
+            member.join();
+        }
+
+        sink = found[0];
+    });
+
+    if (runner.lastNsPerOp() > 0.0)
+    {
+        runner.counter("readers", readers);
+        runner.counter("reads_per_second", reads / (runner.lastNsPerOp() * 1e-9 * ops));
+        runner.counter("versions_published", static_cast<double>(c.version() - before));
+    }
+}
+
+
+void benchmarkDynamicShortestPaths(BenchRunner& runner, const BenchGraph& graph, const BenchOptions&)
+{
+    long long e = static_cast<long long>(graph.edges.size());
+    std::function<double(const double&)> weight = [](const double& w) { return w; };
+
+    // The source is the vertex with the most edges out of it, since a
+    // vertex picked at random from a power-law graph often reaches
+    // hardly anything.
+    BenchDigraph d = buildDigraph(graph);
+    int source = 0;
+
+    for (int vertex = 1; vertex < graph.vertices; ++vertex)
+    {
+        if (d.edgeCount(vertex) > d.edgeCount(source))
+        {
+            source = vertex;
+        }
+    }
+
+    std::vector<int> sources{source};
+
+    runner.run(graph, "DynamicShortestPaths/construct", 1, e, [&]
+    {
+        DynamicShortestPaths<BenchPoint, double> paths{d, sources, weight};
+        sink = paths.predecessor(source, source);
+    });
+
+    DynamicShortestPaths<BenchPoint, double> paths{d, sources, weight};
+    std::vector<int> vertices = randomVertices(graph, 1000, 7);
+
+    runner.run(graph, "DynamicShortestPaths/distance", 1000, 0, [&]
+    {
+        double total = 0.0;
+
+        for (int vertex : vertices)
+        {
+            total += paths.distance(source, vertex);
+        }
+
+        sink = static_cast<long long>(total);
+    });
+
+    // Changing an edge on the shortest path tree makes the repair
+    // search the subtree below it; changing any other edge takes no
+    // more than a look at it.  Both are timed, next to the full search
+    // findShortestPaths() would make instead.
+    std::vector<DigraphEdge<double>> treeEdges;
+
+    for (int vertex : vertices)
+    {
+        int predecessor = paths.predecessor(source, vertex);
+
+        if (predecessor != vertex)
+        {
+            treeEdges.push_back(DigraphEdge<double>{predecessor, vertex, d.edgeInfo(predecessor, vertex)});
+        }
+    }
+
+    std::vector<DigraphEdge<double>> anyEdges;
+
+    for (int i = 0; i < 1000 && e != 0; ++i)
+    {
+        anyEdges.push_back(graph.edges[(static_cast<long long>(i) * 7919) % e]);
+    }
+
+    runner.run(graph, "DynamicShortestPaths/removeEdge+addEdge (tree edge)", static_cast<long long>(treeEdges.size()), 0, [&]
+    {
+        for (const DigraphEdge<double>& edge : treeEdges)
+        {
+            paths.removeEdge(edge.fromVertex, edge.toVertex);
+            paths.addEdge(edge.fromVertex, edge.toVertex, edge.einfo);
+        }
+    });
+
+    runner.run(graph, "DynamicShortestPaths/removeEdge+addEdge (any edge)", static_cast<long long>(anyEdges.size()), 0, [&]
+    {
+        for (const DigraphEdge<double>& edge : anyEdges)
+        {
+            paths.removeEdge(edge.fromVertex, edge.toVertex);
+            paths.addEdge(edge.fromVertex, edge.toVertex, edge.einfo);
+        }
+    });
+
+    runner.run(graph, "DynamicShortestPaths/setEdgeInfo (tree edge)", 2 * static_cast<long long>(treeEdges.size()), 0, [&]
+    {
+        for (const DigraphEdge<double>& edge : treeEdges)
+        {
+            paths.setEdgeInfo(edge.fromVertex, edge.toVertex, edge.einfo * 2.0);
+            paths.setEdgeInfo(edge.fromVertex, edge.toVertex, edge.einfo);
+        }
+    });
+
+    runner.run(graph, "DynamicShortestPaths/full search to compare", 1, e, [&]
+    {
+        sink = static_cast<long long>(d.findShortestPaths(source, weight).size());
+    });
+}
+
+
+void benchmarkDynamicComponents(BenchRunner& runner, const BenchGraph& graph, const BenchOptions&)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    long long e = static_cast<long long>(graph.edges.size());
+    BenchDigraph d = buildDigraph(graph);
+
+    runner.run(graph, "DynamicComponents/construct+componentCount", 1, e, [&]
+    {
+        DynamicComponents<BenchPoint, double> components{d};
+        sink = components.componentCount();
+    });
+
+    DynamicComponents<BenchPoint, double> components{d};
+    sink = components.componentCount();
+
+    // Insertions are what DynamicComponents handles incrementally, so
+    // edges that aren't in the graph yet are added, asking for the
+    // component count after each one, and then taken out again,
+    // untimed.
+    std::unordered_set<long long> present;
+
+    for (const DigraphEdge<double>& edge : graph.edges)
+    {
+        present.insert(static_cast<long long>(edge.fromVertex) * graph.vertices + edge.toVertex);
+    }
+
+    std::mt19937_64 random{8};
+    std::uniform_int_distribution<int> vertex{0, graph.vertices - 1};
+    std::vector<DigraphEdge<double>> added;
+    std::vector<std::pair<int, int>> addedPairs;
+
+    for (int tries = 0; tries < 100000 && added.size() < 1000; ++tries)
+    {
+        int from = vertex(random);
+        int to = vertex(random);
+
+        if (from != to && present.insert(static_cast<long long>(from) * graph.vertices + to).second)
+        {
+            added.push_back(DigraphEdge<double>{from, to, 1.0});
+            addedPairs.emplace_back(from, to);
+        }
+    }
+
+    runner.runTimed(graph, "DynamicComponents/addEdge+componentCount", static_cast<long long>(added.size()), 0, [&]
+    {
+        Clock::time_point start = Clock::now();
+
+        for (const DigraphEdge<double>& edge : added)
+        {
+            components.addEdge(edge.fromVertex, edge.toVertex, edge.einfo);
+            sink = components.componentCount();
+        }
+
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        components.removeEdges(addedPairs);
+        sink = components.componentCount();
+        return elapsed;
+    });
+
+    // A removal leaves the components to be found from scratch by the
+    // next query, so this costs a full search per edge.
+    std::vector<DigraphEdge<double>> removed;
+
+    for (int i = 0; i < 16 && e != 0; ++i)
+    {
+        const DigraphEdge<double>& edge = graph.edges[(static_cast<long long>(i) * 7919) % e];
+
+        if (std::find_if(removed.begin(), removed.end(), [&](const DigraphEdge<double>& r)
+            {
+                return r.fromVertex == edge.fromVertex && r.toVertex == edge.toVertex;
+            }) == removed.end())
+        {
+            removed.push_back(edge);
+        }
+    }
+
+    runner.runTimed(graph, "DynamicComponents/removeEdge+componentCount", static_cast<long long>(removed.size()), 0, [&]
+    {
+        double elapsed = 0.0;
+
+        for (const DigraphEdge<double>& edge : removed)
+        {
+            Clock::time_point start = Clock::now();
+            components.removeEdge(edge.fromVertex, edge.toVertex);
+            sink = components.componentCount();
+            elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+
+            components.addEdge(edge.fromVertex, edge.toVertex, edge.einfo);
+        }
+
+        return elapsed;
+    });
+}
+
+
+void benchmarkContractionHierarchy(BenchRunner& runner, const BenchGraph& graph, const BenchOptions& options)
+{
+    // Contraction hierarchies are meant for road-like graphs; on random
+    // graphs with no hierarchy to find, preprocessing takes very long.
+    if (!graph.hasCoordinates
+        || !(runner.wants(graph, "ContractionHierarchy/build") || runner.wants(graph, "ContractionHierarchy/distance")
+             || runner.wants(graph, "ContractionHierarchy/route")))
+    {
+        return;
+    }
+
+    long long e = static_cast<long long>(graph.edges.size());
+    auto weight = [](const double& w) { return w; };
+
+    FrozenDigraph<BenchPoint, double> f{buildDigraph(graph)};
+    ContractionHierarchy hierarchy;
+
+    runner.run(graph, "ContractionHierarchy/build", 1, e, [&]
+    {
+        hierarchy = ContractionHierarchy{f, weight, options.threads};
+    });
+
+    if (hierarchy.vertexCount() == 0)
+    {
+        hierarchy = ContractionHierarchy{f, weight, options.threads};
+    }
+
+    runner.counter("hierarchy_edges", hierarchy.edgeCount());
+
+    std::vector<int> sources = randomVertices(graph, 1000, 3);
+    std::vector<int> targets = randomVertices(graph, 1000, 4);
+    ContractionHierarchy::Query query;
+
+    runner.run(graph, "ContractionHierarchy/distance", 1000, 0, [&]
+    {
+        double total = 0.0;
+
+        for (std::size_t i = 0; i < sources.size(); ++i)
+        {
+            total += hierarchy.distance(sources[i], targets[i], query);
+        }
+
+        sink = static_cast<long long>(total);
+    });
+
+    long long settled = 0;
+    long long queries = 0;
+
+    runner.run(graph, "ContractionHierarchy/route", 1000, 0, [&]
+    {
+        for (std::size_t i = 0; i < sources.size(); ++i)
+        {
+            settled += hierarchy.route(sources[i], targets[i], query).settled;
+            ++queries;
+        }
+    });
+
+    runner.counter("settled_per_query", static_cast<double>(settled) / std::max(queries, 1LL));
+}
+
+
+void benchmarkMyGraphType(BenchRunner& runner, const BenchGraph& graph, const BenchOptions& options)
+{
+    long long e = static_cast<long long>(graph.edges.size());
+
+    if (!writeAdjacencyFile(graph, options.scratchPath))
+    {
+        std::cerr << "Could not write " << options.scratchPath << std::endl;
+        return;
+    }
+
+    runner.run(graph, "MyGraphType/loadFromFile per edge", e, e, [&]
+    {
+        MyGraphType<int, 0> g;
+        sink = g.loadFromFile(options.scratchPath);
+    });
+
+    MyGraphType<int, 0> g;
+    g.loadFromFile(options.scratchPath);
+    std::remove(options.scratchPath.c_str());
+
+    struct CountingVisitor : GraphVisitor
+    {
+        long long discovered = 0;
+        void discoverVertex(int) { ++discovered; }
+    };
+
+    runner.run(graph, "MyGraphType/depthFirstTraversal", 1, e, [&]
+    {
+        CountingVisitor visitor;
+        g.depthFirstTraversal(visitor);
+        sink = visitor.discovered;
+    });
+
+    runner.run(graph, "MyGraphType/breadthFirstTraversal", 1, e, [&]
+    {
+        CountingVisitor visitor;
+        g.breadthFirstTraversal(visitor);
+        sink = visitor.discovered;
+    });
+
+    runner.run(graph, "MyGraphType/breadthFirstSearch", 1, e, [&]
+    {
+        sink = g.breadthFirstSearch(0, options.threads).level.back();
+    });
+
+    // The printing operations write to std::cout through a BufferedSink;
+    // std::cout is pointed at a DiscardBuffer while they're timed.
+    DiscardBuffer discard;
+    std::streambuf* screen = std::cout.rdbuf(&discard);
+
+    runner.run(graph, "MyGraphType/printGraph per edge", e, e, [&]
+    {
+        g.printGraph();
+    });
+
+    runner.run(graph, "MyGraphType/depthFirstTraversal(print)", 1, e, [&]
+    {
+        g.depthFirstTraversal();
+    });
+
+    runner.run(graph, "MyGraphType/breadthFirstTraversal(print)", 1, e, [&]
+    {
+        g.breadthFirstTraversal();
+    });
+
+    std::cout.rdbuf(screen);
+}
+
+
+
+// parseOptions() reads the command line into options, returning false
+// (after saying why) if it can't.
+
+bool parseOptions(int argc, char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string flag = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << flag << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+
+        if (flag == "--vertices")
+        {
+            options.vertices = std::atoi(value.c_str());
+        }
+        else if (flag == "--edges")
+        {
+            options.edges = std::atoll(value.c_str());
+        }
+        else if (flag == "--graphs")
+        {
+            options.graphs.clear();
+            std::istringstream names{value};
+
+            for (std::string name; std::getline(names, name, ','); )
+            {
+                options.graphs.push_back(name);
+            }
+        }
+        else if (flag == "--filter")
+        {
+            options.filter = value;
+        }
+        else if (flag == "--min-time")
+        {
+            options.minTime = std::atof(value.c_str());
+        }
+        else if (flag == "--threads")
+        {
+            options.threads = static_cast<unsigned>(std::atoi(value.c_str()));
+        }
+        else if (flag == "--json")
+        {
+            options.jsonPath = value;
+        }
+        else if (flag == "--scratch")
+        {
+            options.scratchPath = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return false;
+        }
+    }
+
+    if (options.vertices < 2 || options.edges < 0)
+    {
+        std::cerr << "The graph needs at least 2 vertices" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    BenchOptions options{10000, 50000, {"er", "rmat", "grid"}, "", 0.2, 0, "", "benchmark.tmp"};
+
+    if (!parseOptions(argc, argv, options))
+    {
+        return 1;
+    }
+
+    BenchRunner runner{options};
+    std::mt19937_64 random{20190301};
+    bool scaled = false;
+
+    for (const std::string& kind : options.graphs)
+    {
+        BenchGraph graph;
+
+        if (kind == "er")
+        {
+            graph = erdosRenyi(options.vertices, options.edges, random);
+        }
+        else if (kind == "rmat")
+        {
+            graph = rmat(options.vertices, options.edges, random);
+        }
+        else if (kind == "grid")
+        {
+            graph = grid(options.vertices, random);
+        }
+        else
+        {
+            std::cerr << "Unknown graph kind " << kind << std::endl;
+            return 1;
+        }
+
+        benchmarkAllocator<std::allocator<char>>(runner, graph, "std::allocator");
+        benchmarkAllocator<DigraphPoolAllocator<char>>(runner, graph, "DigraphPoolAllocator");
+        benchmarkDigraph(runner, graph, options);
+        benchmarkFrozenDigraph(runner, graph, options);
+        scaled = benchmarkScaling(runner, graph, options) || scaled;
+        benchmarkConcurrentDigraph(runner, graph, options);
+        benchmarkDynamicShortestPaths(runner, graph, options);
+        benchmarkDynamicComponents(runner, graph, options);
+        benchmarkContractionHierarchy(runner, graph, options);
+        benchmarkMyGraphType(runner, graph, options);
+    }
+
+    // If none of the graphs was big enough for the parallel search to
+    // use more than one thread, the scaling runs get one of their own:
+    // an Erdos-Renyi graph twice that size, with the same number of
+    // edges per vertex as the others.
+    if (!scaled && options.vertices < csrParallelDeltaSteppingThreshold)
+    {
+        int vertices = 2 * csrParallelDeltaSteppingThreshold;
+        long long edges = vertices * std::max(1LL, options.edges / options.vertices);
+        BenchGraph graph = erdosRenyi(vertices, edges, random);
+        graph.name = "scaling-er";
+        benchmarkScaling(runner, graph, options);
+    }
+
+    if (!options.jsonPath.empty())
+    {
+        std::ofstream json{options.jsonPath};
+        runner.writeJson(json);
+
+        if (!json)
+        {
+            std::cerr << "Could not write " << options.jsonPath << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -1,21 +1,146 @@
 #ifndef DIRECTED_GRAPH_H
 #define DIRECTED_GRAPH_H
 
+#include <cstddef>
 #include <fstream> 
+#include <iostream>
+#include <limits>
 #include <queue> 
-#include <list> using namespace std; 
+#include <list> 
+#include <string>
+#include <thread>
+#include <vector>
+#include "DigraphBfs.hpp"
+#include "MappedFile.hpp"
+using namespace std; 
 
+template <class vType>
 class MyList:public list<vType>{ public:
 void getAdjacentVertices(vType [],int &);
 };
 template <class vType>
 void MyList<vType>::getAdjacentVertices(vType adjacencyList[], int &length){ length = 0;
 
-for(list<vType>::iterator it = begin();it != end();++ it){ adjacencyList[length ++] = *it;
+for(typename list<vType>::iterator it = this->begin();it != this->end();++ it){ adjacencyList[length ++] = *it;
+
+}
+}
+
+//GraphVisitor is the visitor that ignores everything.  The traversals
+//below are templates on their visitor's type and call
+//
+//  discoverVertex(u)  when they first reach vertex u
+//  examineEdge(u, w)  for each vertex w adjacent to a vertex u
+//  finishVertex(u)    once they're done with vertex u
+//
+//so a visitor derived from GraphVisitor only has to define the hooks it
+//needs, and the rest compile away to nothing.
+struct GraphVisitor{
+void discoverVertex(int){}
+void examineEdge(int,int){}
+void finishVertex(int){}
+};
+
+//BufferedSink collects text in a fixed buffer and hands it to an
+//ostream in large pieces, so that printing a big graph isn't dominated
+//by formatting and writing one number at a time.  Whatever is left in
+//the buffer is written out when the sink is flushed or destroyed.
+class BufferedSink{
+public:
+explicit BufferedSink(ostream& out = cout);
+~BufferedSink();
+
+BufferedSink(const BufferedSink&) = delete;
+BufferedSink& operator=(const BufferedSink&) = delete;
+
+void put(char c);
+void write(const char* text, size_t length);
+void writeNumber(long long value);
+void flush();
+
+private:
+static const size_t capacity = 1 << 16;
+
+ostream& out;
+size_t used;
+char buffer[capacity];
+};
+
+inline BufferedSink::BufferedSink(ostream& out) : out(out), used(0){
+}
+
+inline BufferedSink::~BufferedSink(){
+    flush();
+}
+
+inline void BufferedSink::put(char c){
+    if(used == capacity){
+        flush();
+    }
+    buffer[used++] = c;
+}
+
+inline void BufferedSink::write(const char* text, size_t length){
+    if(length > capacity - used){
+        flush();
+        if(length > capacity){
+            out.write(text, static_cast<streamsize>(length));
+            return;
+        }
+    }
+    for(size_t i = 0; i < length; ++i){
+        buffer[used + i] = text[i];
+    }
+    used += length;
+}
+
+inline void BufferedSink::writeNumber(long long value){
+    char digits[24];
+    size_t length = 0;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
 
+    do{
+        digits[sizeof(digits) - 1 - length++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    }while(magnitude != 0);
+
+    if(value < 0){
+        digits[sizeof(digits) - 1 - length++] = '-';
+    }
+    write(digits + sizeof(digits) - length, length);
 }
+
+inline void BufferedSink::flush(){
+    if(used != 0){
+        out.write(buffer, static_cast<streamsize>(used));
+        used = 0;
+    }
 }
 
+//PrintVisitor writes each vertex to a sink as it's discovered, in the
+//" v " form the printing traversals have always used.
+class PrintVisitor:public GraphVisitor{
+public:
+explicit PrintVisitor(BufferedSink& sink) : sink(sink){
+}
+
+void discoverVertex(int u){
+    sink.put(' ');
+    sink.writeNumber(u);
+    sink.put(' ');
+}
+
+private:
+BufferedSink& sink;
+};
+
+//MyGraphType grows to fit whatever graph it's given.  Graphs of up to
+//size vertices are kept in slots inside the MyGraphType itself, so a
+//small graph declared as a local variable lives entirely on the stack;
+//bigger graphs move to the heap.  With a size of 0, every graph lives
+//on the heap.
+template <class vType,int size>
+class MyGraphType{
 public:
 
 
@@ -23,38 +148,108 @@ MyGraphType();
 
 ~MyGraphType();
 
+MyGraphType(const MyGraphType&) = delete;
+MyGraphType& operator=(const MyGraphType&) = delete;
+
 
 
 bool isEmpty();
 
-void printGraph();
+void createGraph();
+
+//loadFromFile reads a graph in the same text format createGraph reads
+//(the vertex count, then for each vertex its number, its adjacent
+//vertices and -999), without prompting for anything.  Big files are
+//split at record boundaries and parsed on several threads.  Room for
+//all of the vertices is reserved up front from the count at the top of
+//the file.  It returns false, leaving the graph empty, if the file
+//can't be read or isn't well formed: if it has fewer records than its
+//count says, a record without its -999, or a - that isn't part of a
+//number.
+bool loadFromFile(const string& fileName);
 
-void dft(int v,bool visited[]);
+//reserve makes room for at least the given number of vertices, keeping
+//the adjacency lists of the vertices already in the graph.
+void reserve(int vertices);
 
+void clearGraph();
+
+void printGraph();
+
+//depthFirstSearch searches depth-first from vertex v, skipping
+//vertices already marked in visited and marking every vertex it
+//reaches, and reports what it does to the visitor (see GraphVisitor):
+//a vertex is finished once everything reachable from it has been.  It
+//keeps its own stack instead of recursing, and reuses that stack from
+//one search to the next.  Adjacent vertices that aren't in the graph
+//are ignored.
+template <class Visitor>
+void depthFirstSearch(int v,vector<bool>& visited,Visitor&& visitor);
+
+//The traversals below report to a visitor; the versions without one
+//print the vertices in the order they're discovered.
+template <class Visitor>
+void depthFirstTraversal(Visitor&& visitor);
 void depthFirstTraversal();
+
+template <class Visitor>
+void dftAtVertex(int v,Visitor&& visitor);
 void dftAtVertex(int v);
 
+//breadthFirstTraversal finishes each vertex once all of its adjacent
+//vertices have been examined.
+template <class Visitor>
+void breadthFirstTraversal(Visitor&& visitor);
 void breadthFirstTraversal();
+
+//breadthFirstSearch searches the graph breadth-first from vertex v,
+//spreading the work over the given number of threads (one per
+//hardware thread if it's 0), and returns the level and parent of every
+//vertex instead of printing them (see DigraphBfsTree in DigraphBfs.hpp).
+//Adjacent vertices that aren't in the graph are ignored.
+DigraphBfsTree breadthFirstSearch(int v, unsigned threads = 0);
  
 private:
 
 int maxSize;
 int gSize;
 
+//graph points at inlineSlots until the graph outgrows them, and at
+//heapSlots after that
 MyList<vType>*graph;
+MyList<vType> inlineSlots[size > 0 ? size : 1];
+vector<MyList<vType>> heapSlots;
+
+//files smaller than this are parsed on a single thread
+static const size_t parallelLoadThreshold = 1 << 20;
+
+//readNumber skips ahead to the next number and reads it, returning
+//false if there isn't one; p is left at end if the input ran out, and
+//at the offending character if it found a - without digits after it
+static bool readNumber(const char*& p, const char* end, long long& value);
+static const char* nextRecordBoundary(const char* p, const char* begin, const char* end);
+//parseRecords returns false if the records are malformed
+static bool parseRecords(const char* p, const char* end, vector<vType>& values, vector<size_t>& starts);
+
+//dfsStack is depthFirstSearch's stack of (vertex, next adjacent
+//vertex) pairs
+vector<pair<int,typename list<vType>::iterator>> dfsStack;
+
+//buildCsr packs the adjacency lists into csr, numbering each vertex as
+//itself
+void buildCsr(DigraphCsr& csr);
 };
 template <class vType,int size> MyGraphType<vType,size>::MyGraphType(){
 
 
 maxSize = size;
 gSize = 0;
-graph = new MyList<vType>[maxSize];
+graph = inlineSlots;
 }
 
 template <class vType,int size> MyGraphType<vType,size>::~MyGraphType(){
 
 clearGraph();
-delete []graph;
 
 }
 template <class vType,int size>
@@ -63,52 +258,196 @@ bool MyGraphType<vType,size>::isEmpty(){ return (0 == gSize);
 }
 
 template <class vType,int size>
-void MyGraphType<vType,size>::createGraph(){ ifstream infile;
-char fileName[50];
-vType vertex;
-
-vType adjacencyVertex;
-
-if(0 != gSize){
-clearGraph();
-
-}
+void MyGraphType<vType,size>::createGraph(){ string fileName;
 
 cout<<"Enter the input file name:";
 cin>>fileName;
 
-
-infile.open(fileName);
-
-if(infile.fail()){
-cout<<infile.fail()<<endl;
-
+if(!loadFromFile(fileName)){
 cout<<"Can't open the file!"<<endl;
-return;
+}
 }
 
+template <class vType,int size>
+bool MyGraphType<vType,size>::loadFromFile(const string& fileName){
+    if(0 != gSize){
+        clearGraph();
+    }
+
+    MappedFile file(fileName);
+    if(!file.isOpen()){
+        return false;
+    }
+
+    const char* p = file.data();
+    const char* end = p + file.size();
+    long long count;
+
+    if(!readNumber(p, end, count) || count < 0 || count > numeric_limits<int>::max()){
+        return false;
+    }
+
+    reserve(static_cast<int>(count));
+
+    //split the rest of the file into one chunk per thread, moving each
+    //split point forward to the end of a record
+    size_t threads = 1;
+    if(file.size() >= parallelLoadThreshold){
+        threads = max(1u, thread::hardware_concurrency());
+    }
+
+    vector<const char*> bounds(1, p);
+    for(size_t t = 1; t < threads; ++t){
+        const char* nominal = p + (end - p) * t / threads;
+        bounds.push_back(max(bounds.back(), nextRecordBoundary(nominal, p, end)));
+    }
+    bounds.push_back(end);
+
+    vector<vector<vType>> values(threads);
+    vector<vector<size_t>> starts(threads);
+    vector<char> parsed(threads);
+    vector<thread> workers;
+
+    auto parse = [&](size_t t){
+        parsed[t] = parseRecords(bounds[t], bounds[t + 1], values[t], starts[t]);
+    };
+
+    for(size_t t = 1; t < threads; ++t){
+        workers.emplace_back(parse, t);
+    }
+    parse(0);
+    for(thread& w : workers){
+        w.join();
+    }
+    workers.clear();
+
+    size_t records = 0;
+    for(size_t t = 0; t < threads; ++t){
+        if(!parsed[t]){
+            return false;
+        }
+        records += starts[t].size() - 1;
+    }
+    if(records < static_cast<size_t>(count)){
+        return false;
+    }
+
+    //every chunk knows which vertex its first record belongs to, so the
+    //chunks can fill in their adjacency lists in parallel too
+    gSize = static_cast<int>(count);
+    vector<size_t> firstVertex(threads + 1, 0);
+    for(size_t t = 0; t < threads; ++t){
+        firstVertex[t + 1] = firstVertex[t] + (starts[t].empty() ? 0 : starts[t].size() - 1);
+    }
+
+    auto fill = [&](size_t t){
+        for(size_t r = 0; r + 1 < starts[t].size() && firstVertex[t] + r < static_cast<size_t>(gSize); ++r){
+            graph[firstVertex[t] + r].assign(values[t].begin() + starts[t][r], values[t].begin() + starts[t][r + 1]);
+        }
+    };
+
+    for(size_t t = 1; t < threads; ++t){
+        workers.emplace_back(fill, t);
+    }
+    fill(0);
+    for(thread& w : workers){
+        w.join();
+    }
+
+    return true;
+}
 
-infile>>gSize;
-for(int i(0);i < gSize;++ i){
-
-infile>>vertex;
-
-
-infile>>adjacencyVertex;
-
-while(adjacencyVertex != -999){
-graph[i].push_back(adjacencyVertex);
- 
-infile>>adjacencyVertex;
-
+template <class vType,int size>
+bool MyGraphType<vType,size>::readNumber(const char*& p, const char* end, long long& value){
+    while(p != end && (*p < '0' || *p > '9') && *p != '-'){
+        ++p;
+    }
+    if(p == end){
+        return false;
+    }
+
+    const char* start = p;
+    bool negative = (*p == '-');
+    if(negative){
+        ++p;
+    }
+    if(p == end || *p < '0' || *p > '9'){
+        p = start;
+        return false;
+    }
+
+    value = 0;
+    while(p != end && *p >= '0' && *p <= '9'){
+        value = value * 10 + (*p - '0');
+        ++p;
+    }
+    if(negative){
+        value = -value;
+    }
+    return true;
 }
+
+template <class vType,int size>
+const char* MyGraphType<vType,size>::nextRecordBoundary(const char* p, const char* begin, const char* end){
+    //start from the beginning of the next line, so that p isn't in the
+    //middle of a number, then stop just past the next -999
+    while(p != end && p != begin && p[-1] != '\n'){
+        ++p;
+    }
+
+    long long value;
+    while(readNumber(p, end, value)){
+        if(value == -999){
+            return p;
+        }
+    }
+    return end;
 }
 
+template <class vType,int size>
+bool MyGraphType<vType,size>::parseRecords(const char* p, const char* end, vector<vType>& values, vector<size_t>& starts){
+    //each record is a vertex number followed by its adjacent vertices
+    //and -999; record r's adjacent vertices end up in
+    //values[starts[r]] through values[starts[r + 1] - 1]
+    long long value;
+    starts.push_back(0);
+
+    while(readNumber(p, end, value)){
+        bool terminated = false;
+        while(readNumber(p, end, value)){
+            if(value == -999){
+                terminated = true;
+                break;
+            }
+            values.push_back(static_cast<vType>(value));
+        }
+        if(!terminated){
+            return false;
+        }
+        starts.push_back(values.size());
+    }
+    return p == end;
+}
 
-infile.close();
+template <class vType,int size>
+void MyGraphType<vType,size>::reserve(int vertices){
+    if(vertices <= maxSize){
+        return;
+    }
+
+    vector<MyList<vType>> grown(vertices);
+    for(int i = 0; i < gSize; ++i){
+        grown[i].swap(graph[i]);
+    }
+
+    heapSlots.swap(grown);
+    graph = heapSlots.data();
+    maxSize = vertices;
 }
+
 template <class vType,int size>
-void MyGraphType<vType,size>::clearGraph(){ //clear all the graph lists for(int i = 0;i < gSize;++ i){
+void MyGraphType<vType,size>::clearGraph(){ //clear all the graph lists
+for(int i = 0;i < gSize;++ i){
 graph[i].clear();
 }
 gSize = 0;
@@ -116,123 +455,157 @@ gSize = 0;
 }
 template <class vType,int size>
 void MyGraphType<vType,size>::printGraph(){
-
+BufferedSink sink;
 
 for(int i = 0;i < gSize;++ i){
-cout<<i<<"->";
-for(list<vType>::iterator it = graph[i].begin();it != graph[i].end();++ it){
+sink.writeNumber(i);
+sink.write("->", 2);
+for(typename list<vType>::iterator it = graph[i].begin();it != graph[i].end();++ it){
 
-cout<<*it<<" ";
+sink.writeNumber(*it);
+sink.put(' ');
 
 }
-cout<<endl;
+sink.put('\n');
 }
 }
 template <class vType,int size>
-
-void MyGraphType<vType,size>::dft(int v, bool visited[]){ vType w;
-
-
-
-adjacencyList = new vType[gSize];
-int alLength = 0;
-visited[v] = true;
-
-
-cout<<" "<<v<<" ";
-
-graph[v].getAdjacentVertices(adjacencyList,alLength);
-for(int i(0);i <alLength;++ i){
-w = adjacencyList[i];
-
-if(!visited[w]){
-
-dft(w,visited);
-}
-}
-
-
-delete [] adjacencyList;
+template <class Visitor>
+void MyGraphType<vType,size>::depthFirstSearch(int v,vector<bool>& visited,Visitor&& visitor){
+    if(v < 0 || v >= gSize || visited[v]){
+        return;
+    }
+
+    visited[v] = true;
+    visitor.discoverVertex(v);
+    dfsStack.clear();
+    dfsStack.push_back(make_pair(v, graph[v].begin()));
+
+    while(!dfsStack.empty()){
+        int u = dfsStack.back().first;
+        typename list<vType>::iterator& next = dfsStack.back().second;
+
+        if(next == graph[u].end()){
+            dfsStack.pop_back();
+            visitor.finishVertex(u);
+            continue;
+        }
+
+        int w = static_cast<int>(*next);
+        ++next;
+
+        if(w < 0 || w >= gSize){
+            continue;
+        }
+
+        visitor.examineEdge(u, w);
+
+        if(!visited[w]){
+            visited[w] = true;
+            visitor.discoverVertex(w);
+            dfsStack.push_back(make_pair(w, graph[w].begin()));
+        }
+    }
 }
 
 template <class vType,int size>
+template <class Visitor>
+void MyGraphType<vType,size>::depthFirstTraversal(Visitor&& visitor){
+    vector<bool> visited(gSize, false);
 
-void MyGraphType<vType,size>::depthFirstTraversal(){ bool *visited;
-visited = new bool[gSize];
-
- 
-for(int i(0);i < gSize;++ i){
-
-visited[i] = false;
+    for(int i(0);i < gSize;++ i){
+        depthFirstSearch(i,visited,visitor);
+    }
 }
 
-
-for(int i(0);i < gSize;++ i){
-if(!visited[i]){
-dft(i,visited);
+template <class vType,int size>
+void MyGraphType<vType,size>::depthFirstTraversal(){
+    BufferedSink sink;
+    depthFirstTraversal(PrintVisitor(sink));
 }
 
-}
-delete [] visited;
-}
 template <class vType,int size>
-void MyGraphType<vType,size>::dftAtVertex(int v){ bool *visited;
-visited = new bool[gSize];
-for(int i(0);i < gSize;++ i){
-visited[i] = false;
+template <class Visitor>
+void MyGraphType<vType,size>::dftAtVertex(int v,Visitor&& visitor){
+    vector<bool> visited(gSize, false);
+    depthFirstSearch(v,visited,visitor);
 }
 
-
-dft(v,visited);
-delete [] visited;
+template <class vType,int size>
+void MyGraphType<vType,size>::dftAtVertex(int v){
+    BufferedSink sink;
+    dftAtVertex(v,PrintVisitor(sink));
 }
 
-
 template <class vType,int size>
-void MyGraphType<vType,size>::breadthFirstTraversal(){ queue<vType> Queue;
-int u;
-bool *visited;
-
-
-visited = new bool[gSize];
-for(int i(0);i < gSize;++ i){
-visited[i] = false;
+template <class Visitor>
+void MyGraphType<vType,size>::breadthFirstTraversal(Visitor&& visitor){
+    vector<bool> visited(gSize, false);
+    queue<int> Queue;
+
+    for(int i(0);i < gSize;++ i){
+        if(visited[i]){
+            continue;
+        }
+
+        visited[i] = true;
+        visitor.discoverVertex(i);
+        Queue.push(i);
+
+        while(!Queue.empty()){
+            int u = Queue.front();
+            Queue.pop();
+
+            for(typename list<vType>::iterator it = graph[u].begin();it != graph[u].end();++ it){
+                int w = static_cast<int>(*it);
+
+                if(w < 0 || w >= gSize){
+                    continue;
+                }
+
+                visitor.examineEdge(u, w);
+
+                if(!visited[w]){
+                    visited[w] = true;
+                    visitor.discoverVertex(w);
+                    Queue.push(w);
+                }
+            }
+
+            visitor.finishVertex(u);
+        }
+    }
 }
 
-
-adjacencyList = new vType[gSize];
-int alLength = 0;
-
-for(int i(0);i < gSize;++ i){
-
-
-Queue.push(i);
-
-visited[i] = true;
-cout<<" "<<i<<" ";
-while(Queue.size() != 0){
-
-u = Queue.front();
-
-Queue.pop();
-
-for(int j(0);j < alLength;++ j){
-if(!visited[adjacencyList[j]]){
-Queue.push(adjacencyList[j]);
-visited[adjacencyList[j]] = true;
- 
-cout<<" "<<adjacencyList[j]<<" ";
-
-}
+template <class vType,int size>
+void MyGraphType<vType,size>::breadthFirstTraversal(){
+    BufferedSink sink;
+    breadthFirstTraversal(PrintVisitor(sink));
 }
 
+template <class vType,int size>
+DigraphBfsTree MyGraphType<vType,size>::breadthFirstSearch(int v, unsigned threads){
+    DigraphCsr csr;
+    buildCsr(csr);
+    return csrBfsTree(csr, v, threads);
 }
-}
-}
-//deallocate
-delete []visited;
 
-delete []adjacencyList;
+template <class vType,int size>
+void MyGraphType<vType,size>::buildCsr(DigraphCsr& csr){
+    csr.numbers.resize(gSize);
+    csr.offsets.assign(1, 0);
+    csr.offsets.reserve(gSize + 1);
+    csr.targets.clear();
+
+    for(int i = 0; i < gSize; ++i){
+        csr.numbers[i] = i;
+        for(typename list<vType>::iterator it = graph[i].begin(); it != graph[i].end(); ++it){
+            if(*it >= 0 && *it < gSize){
+                csr.targets.push_back(static_cast<int>(*it));
+            }
+        }
+        csr.offsets.push_back(static_cast<int>(csr.targets.size()));
+    }
 }
 
 #endif
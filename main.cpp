@@ -1,5 +1,5 @@
 #include <iostream>
-#include "MyGraph.h"
+#include "directed_graph.hpp"
 using namespace std;
 int main(){
 MyGraphType<int,100>myGraph;
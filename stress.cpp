@@ -0,0 +1,332 @@
+// stress.cpp
+//
+// This is a stress test for ConcurrentDigraph.  Writer threads keep
+// changing a graph while reader threads keep taking snapshots of it and
+// checking that:
+//
+// * a snapshot never changes while it's held: its vertices and edges,
+//   read again after the reader has run a query on it and the writers
+//   have had time to publish, are exactly what they were at first
+// * every snapshot is a version some writer published whole, never a
+//   half-made change: the writers only ever publish a path 0 -> 1 ->
+//   ... -> k, so a snapshot has one edge fewer than it has vertices,
+//   and every edge joins two consecutive vertices
+// * version() only ever increases, and so does the size of the graph a
+//   reader sees from one snapshot to the next, since the writers never
+//   shrink it
+//
+// The writers grow the path one vertex at a time with update(), and
+// now and then remove the path's last edge and put it back, so that
+// removals get published too.
+//
+// It builds on its own, like benchmark.cpp:
+//
+//     g++ -std=c++11 -O2 -pthread stress.cpp -o stress
+//
+// Usage:
+//
+//     stress [--seconds S] [--readers R] [--writers W]
+//
+// It prints "ok" and exits with status 0 if every check passed, or
+// describes the first failure and exits with status 1.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "ConcurrentDigraph.hpp"
+
+
+
+typedef ConcurrentDigraph<int, double> StressDigraph;
+typedef StressDigraph::Snapshot StressSnapshot;
+
+
+// A StressFailure records the first failed check, whichever thread
+// makes it.
+
+class StressFailure
+{
+public:
+    StressFailure();
+
+    // fail() records the given description, unless a failure has
+    // already been recorded.
+    void fail(const std::string& what);
+
+    // failed() returns true once any failure has been recorded, and
+    // description() returns the first one.
+    bool failed() const noexcept;
+    std::string description() const;
+
+
+private:
+    mutable std::mutex lock;
+    std::atomic<bool> any;
+    std::string first;
+};
+
+
+
+StressFailure::StressFailure()
+    : any{false}
+{
+}
+
+
+void StressFailure::fail(const std::string& what)
+{
+    std::lock_guard<std::mutex> guard{lock};
+
+    if (!any)
+    {
+        first = what;
+        any = true;
+    }
+}
+
+
+bool StressFailure::failed() const noexcept
+{
+    return any;
+}
+
+
+std::string StressFailure::description() const
+{
+    std::lock_guard<std::mutex> guard{lock};
+    return first;
+}
+
+
+
+// checkPath() returns an empty string if the snapshot holds a path
+// 0 -> 1 -> ... -> k, or describes what's wrong with it.
+
+std::string checkPath(const StressSnapshot& snapshot)
+{
+    int vertices = snapshot->vertexCount();
+
+    if (snapshot->edgeCount() != vertices - 1)
+    {
+        return "snapshot with " + std::to_string(vertices) + " vertices has "
+            + std::to_string(snapshot->edgeCount()) + " edges";
+    }
+
+    for (const std::pair<int, int>& edge : snapshot->edges())
+    {
+        if (edge.second != edge.first + 1 || edge.second >= vertices)
+        {
+            return "snapshot has an edge " + std::to_string(edge.first) + " -> " + std::to_string(edge.second);
+        }
+    }
+
+    return "";
+}
+
+
+// writer() grows the path until told to stop.
+
+void writer(StressDigraph& c, std::atomic<int>& next, std::atomic<bool>& stop)
+{
+    while (!stop)
+    {
+        c.update([&](Digraph<int, double>& d)
+        {
+            int vertex = next++;
+            d.addVertex(vertex, vertex);
+            d.addEdge(vertex - 1, vertex, 1.0);
+
+            if (vertex % 8 == 0)
+            {
+                d.removeEdge(vertex - 1, vertex);
+                d.addEdge(vertex - 1, vertex, 2.0);
+            }
+        });
+    }
+}
+
+
+// reader() takes snapshots and checks them until told to stop.
+
+void reader(StressDigraph& c, StressFailure& failure, std::atomic<bool>& stop, long long& checked)
+{
+    unsigned long lastVersion = 0;
+    int lastVertices = 0;
+
+    while (!stop && !failure.failed())
+    {
+        unsigned long version = c.version();
+
+        if (version < lastVersion)
+        {
+            failure.fail("version() went from " + std::to_string(lastVersion) + " to " + std::to_string(version));
+            return;
+        }
+
+        lastVersion = version;
+
+        StressSnapshot snapshot = c.snapshot();
+        std::vector<std::pair<int, int>> edges = snapshot->edges();
+        int vertices = snapshot->vertexCount();
+
+        if (vertices < lastVertices)
+        {
+            failure.fail("a later snapshot had " + std::to_string(vertices) + " vertices, down from "
+                         + std::to_string(lastVertices));
+            return;
+        }
+
+        lastVertices = vertices;
+        std::string problem = checkPath(snapshot);
+
+        if (!problem.empty())
+        {
+            failure.fail(problem);
+            return;
+        }
+
+        // Give the writers time to publish while the snapshot is held,
+        // then make sure it hasn't changed.
+        std::map<int, double> distances;
+        snapshot->findShortestPaths(0, [](const double& w) { return w; }, distances);
+        std::this_thread::yield();
+
+        if (distances.size() != static_cast<std::size_t>(vertices)
+            || snapshot->vertexCount() != vertices || snapshot->edges() != edges)
+        {
+            failure.fail("a snapshot changed while it was held");
+            return;
+        }
+
+        ++checked;
+    }
+}
+
+
+// parseOptions() reads the command line, returning false (after saying
+// why) if it can't.
+
+bool parseOptions(int argc, char** argv, double& seconds, int& readers, int& writers)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string flag = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << flag << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+
+        if (flag == "--seconds")
+        {
+            seconds = std::atof(value.c_str());
+        }
+        else if (flag == "--readers")
+        {
+            readers = std::atoi(value.c_str());
+        }
+        else if (flag == "--writers")
+        {
+            writers = std::atoi(value.c_str());
+        }
+        else
+        {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return false;
+        }
+    }
+
+    if (readers < 1 || writers < 1)
+    {
+        std::cerr << "There must be at least one reader and one writer" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    double seconds = 2.0;
+    int readers = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+    int writers = 2;
+
+    if (!parseOptions(argc, argv, seconds, readers, writers))
+    {
+        return 1;
+    }
+
+    Digraph<int, double> start;
+    start.addVertex(0, 0);
+    StressDigraph c{start};
+
+    StressFailure failure;
+    std::atomic<bool> stop{false};
+    std::atomic<int> next{1};
+    std::vector<long long> checked(readers);
+    std::vector<std::thread> threads;
+
+    for (int w = 0; w < writers; ++w)
+    {
+        threads.emplace_back(writer, std::ref(c), std::ref(next), std::ref(stop));
+    }
+
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back(reader, std::ref(c), std::ref(failure), std::ref(stop), std::ref(checked[r]));
+    }
+
+    std::chrono::steady_clock::time_point until =
+        std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+
+    while (std::chrono::steady_clock::now() < until && !failure.failed())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    stop = true;
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (failure.failed())
+    {
+        std::cout << "FAILED: " << failure.description() << std::endl;
+        return 1;
+    }
+
+    long long snapshots = 0;
+
+    for (long long count : checked)
+    {
+        snapshots += count;
+    }
+
+    std::string problem = checkPath(c.snapshot());
+
+    if (!problem.empty() || c.snapshot()->vertexCount() != next)
+    {
+        std::cout << "FAILED: final graph is wrong" << (problem.empty() ? "" : ": " + problem) << std::endl;
+        return 1;
+    }
+
+    std::cout << "ok: " << snapshots << " snapshots checked, " << c.version() << " versions published" << std::endl;
+    return 0;
+}